@@ -0,0 +1,136 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_bench.hpp"
+
+#include <string>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Compares the storage backends: the cost of creating and of attaching to
+// the memory, of the first touch of each page, and of steady-state access.
+// Usage: shmCpp_bench_backends
+
+namespace {
+
+using value_type = uint64_t;
+
+constexpr size_t count {8 * 1024 * 1024};
+constexpr size_t page_values {4096 / sizeof(value_type)};
+constexpr size_t passes {10};
+
+template<class Storage>
+using BenchArray = shm::Array<value_type, count, Storage>;
+
+/** @returns The seconds taken to attach to @a writer's memory, the way an
+ * unrelated process would. */
+template<class Storage>
+double attach(const std::string& name, BenchArray<Storage>&)
+{
+    shm::Options opts;
+    opts.open_mode = shm::OpenMode::Open;
+
+    shmBench::Timer timer;
+    BenchArray<Storage> reader(name, shm::Permissions::ReadOnly, opts);
+    const auto t {timer.seconds()};
+
+    shmBench::do_not_optimise(reader[0]);
+    return t;
+}
+
+template<>
+double attach<shm::MemfdBackend>(const std::string&, BenchArray<shm::MemfdBackend>& writer)
+{
+    // The descriptor was inherited; it could equally have been received
+    shmBench::Timer timer;
+    BenchArray<shm::MemfdBackend> reader(writer.descriptor(), shm::Permissions::ReadOnly);
+    const auto t {timer.seconds()};
+
+    shmBench::do_not_optimise(reader[0]);
+    return t;
+}
+
+template<>
+double attach<shm::AnonymousBackend>(const std::string&, BenchArray<shm::AnonymousBackend>&)
+{
+    // The mapping was inherited: nothing to do
+    return 0;
+}
+
+/** @returns The seconds a forked child takes to attach. */
+template<class Storage>
+double childAttach(const std::string& name, BenchArray<Storage>& writer)
+{
+    int fds[2];
+    if (pipe(fds) == -1)
+        throw std::runtime_error("Failed to create a pipe");
+
+    std::cout.flush();
+    const auto pid {fork()};
+
+    if (pid == 0) {
+        const auto t {attach<Storage>(name, writer)};
+        if (write(fds[1], &t, sizeof(t)) != sizeof(t))
+            _exit(1);
+        _exit(0);
+    }
+    else if (pid < 0) {
+        throw std::runtime_error("Failed to fork");
+    }
+
+    double t {-1};
+    if (read(fds[0], &t, sizeof(t)) != sizeof(t))
+        t = -1;
+
+    waitpid(pid, nullptr, 0);
+    close(fds[0]);
+    close(fds[1]);
+    return t;
+}
+
+template<class Storage>
+void run(const std::string& label, const std::string& name)
+{
+    shmBench::Timer create_timer;
+    BenchArray<Storage> arr(name);
+    const auto create {create_timer.seconds()};
+
+    // Write one value per page, faulting each in
+    shmBench::Timer touch_timer;
+    for (size_t i {0}; i < count; i += page_values)
+        arr[i] = i;
+    const auto touch {touch_timer.seconds()};
+
+    const auto attach {childAttach<Storage>(name, arr)};
+
+    value_type sum {0};
+    shmBench::Timer steady_timer;
+    for (size_t p {0}; p < passes; p++) {
+        for (size_t i {0}; i < count; i++)
+            sum += arr[i];
+        shmBench::do_not_optimise(sum);
+    }
+    const auto steady {steady_timer.seconds()};
+
+    const auto bytes {static_cast<double>(count * sizeof(value_type))};
+
+    std::cout << label << ":\tcreate " << create * 1e6 << " us"
+        << "\tattach " << attach * 1e6 << " us"
+        << "\tfirst touch " << touch / (count / page_values) * 1e9 << " ns/page"
+        << "\tsteady " << bytes * passes / steady / 1e9 << " GB/s\n";
+}
+
+} // namespace
+
+int main() {
+    const std::string name {shm::formatName("ShmCpp_Bench_Backends")};
+    const std::string path {"/tmp/ShmCpp_Bench_Backends"};
+
+    std::cout << "Backends over " << count * sizeof(value_type) / (1024 * 1024) << " MiB\n";
+
+    run<shm::PosixShmBackend>("POSIX shm", name);
+    run<shm::SysVBackend>("System V", name);
+    run<shm::MemfdBackend>("memfd", name);
+    run<shm::FileBackend>("file", path);
+    run<shm::AnonymousBackend>("anonymous", name);
+}
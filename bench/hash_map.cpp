@@ -0,0 +1,119 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_bench.hpp"
+
+#include <sys/stat.h>
+#include <unordered_map>
+
+// Lookup throughput and memory footprint of HashMap, against
+// std::unordered_map holding the same keys, for a table that fits in the
+// caches and one that does not. Lookups are at random, half of them for
+// missing keys. HashMap is kept half full.
+// Usage: shmCpp_bench_hash_map
+
+namespace {
+
+constexpr size_t lookups {20000000};
+
+struct State {
+    uint64_t price;
+    uint64_t quantity;
+    uint32_t flags;
+};
+
+/** Bytes in use through @ref CountingAllocator. */
+size_t allocated {0};
+
+/** Allocator counting the bytes in use. */
+template<class Tp>
+struct CountingAllocator {
+    using value_type = Tp;
+
+    CountingAllocator() = default;
+    template<class U>
+    CountingAllocator(const CountingAllocator<U>&) {}
+
+    Tp* allocate(size_t n)
+    {
+        allocated += n * sizeof(Tp);
+        return std::allocator<Tp>().allocate(n);
+    }
+
+    void deallocate(Tp* p, size_t n)
+    {
+        allocated -= n * sizeof(Tp);
+        std::allocator<Tp>().deallocate(p, n);
+    }
+
+    template<class U>
+    bool operator==(const CountingAllocator<U>&) const { return true; }
+    template<class U>
+    bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+using StdMap = std::unordered_map<uint64_t, State, std::hash<uint64_t>, std::equal_to<uint64_t>,
+    CountingAllocator<std::pair<const uint64_t, State>>>;
+
+/** @returns The @a i th key: sparse, like exchange symbol identifiers. */
+uint64_t key(uint64_t i) {
+    return i * 2654435761ull + 1;
+}
+
+template<class Find>
+void run(const char* label, size_t keys, Find find) {
+    shmBench::Rng rng;
+    uint64_t found {0};
+
+    shmBench::Timer timer;
+    for (size_t i {0}; i < lookups; i++)
+        found += find(key(rng() % (2 * keys)));
+    const auto t {timer.seconds()};
+
+    shmBench::do_not_optimise(found);
+    std::cout << "  " << label << "\t" << lookups / t / 1e6 << " M lookups/s, "
+        << t / lookups * 1e9 << " ns/lookup\n";
+}
+
+template<size_t Buckets>
+void compare() {
+    constexpr size_t keys {Buckets / 2};
+    const auto name {shm::formatName("ShmCpp_Bench_HashMap")};
+    shm_unlink(name.c_str());
+
+    shm::Options opts;
+    opts.populate = true;
+    shm::HashMap<uint64_t, State, Buckets> map(name, shm::Permissions::ReadWrite, opts);
+
+    allocated = 0;
+    StdMap std_map;
+    std_map.reserve(keys);
+
+    for (uint64_t i {0}; i < keys; i++) {
+        const State s {i, i * 2, 0};
+        map.insert(key(i), s);
+        std_map.emplace(key(i), s);
+    }
+
+    // The SMO's size covers the buckets, the count and the segment header
+    struct stat st {};
+    stat(("/dev/shm" + name).c_str(), &st);
+
+    std::cout << keys << " keys: HashMap " << st.st_size / 1e6 << " MB (shared), "
+        << "unordered_map " << allocated / 1e6 << " MB (per process, excluding malloc overhead)\n";
+
+    run("HashMap", keys, [&](uint64_t k) {
+        State s;
+        return map.find(k, s) ? s.quantity : 0;
+    });
+    run("unordered_map", keys, [&](uint64_t k) {
+        const auto it {std_map.find(k)};
+        return it != std_map.end() ? it->second.quantity : 0;
+    });
+}
+
+} // namespace
+
+int main() {
+    compare<1 << 14>();
+    compare<1 << 20>();
+}
@@ -0,0 +1,69 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_bench.hpp"
+
+#include <cstdlib>
+#include <string>
+
+// Random reads from a large shared array, with and without huge pages.
+// Usage: shmCpp_bench_huge_pages [size in MiB]
+
+namespace {
+
+const char* mode_name(shm::HugePages mode) {
+    switch (mode) {
+        case shm::HugePages::None: return "none";
+        case shm::HugePages::Transparent: return "transparent";
+        case shm::HugePages::Explicit: return "explicit";
+    }
+    return "?";
+}
+
+void run(size_t bytes, shm::HugePages mode) {
+    const std::string name {shm::formatName("ShmCpp_Bench_HugePages")};
+    constexpr size_t reads {20000000};
+
+    shm::Options opts;
+    opts.huge_pages = mode;
+
+    shm::DynArray<uint64_t> arr(name, bytes / sizeof(uint64_t), shm::Permissions::ReadWrite, opts);
+
+    // Fault everything in first, so only steady-state access is measured
+    for (size_t i {0}; i < arr.size(); i++)
+        arr[i] = i;
+
+    shmBench::Rng rng;
+    shmBench::TlbMissCounter tlb;
+    uint64_t sum {0};
+
+    tlb.start();
+    shmBench::Timer timer;
+
+    for (size_t i {0}; i < reads; i++)
+        sum += arr[rng() % arr.size()];
+
+    const auto t {timer.seconds()};
+    const auto misses {tlb.stop()};
+    shmBench::do_not_optimise(sum);
+
+    std::cout << "requested " << mode_name(mode)
+        << ", in effect " << mode_name(arr.huge_pages()) << ":\t"
+        << t / reads * 1e9 << " ns/read\t";
+    if (tlb.available())
+        std::cout << static_cast<double>(misses) / reads << " dTLB misses/read\n";
+    else
+        std::cout << "dTLB misses unavailable\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t mib {argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1024};
+    const size_t bytes {mib * 1024 * 1024};
+
+    std::cout << "Random 8-byte reads over " << mib << " MiB\n";
+
+    run(bytes, shm::HugePages::None);
+    run(bytes, shm::HugePages::Transparent);
+    run(bytes, shm::HugePages::Explicit);
+}
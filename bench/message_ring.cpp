@@ -0,0 +1,71 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_bench.hpp"
+
+#include <cstring>
+#include <vector>
+
+// Throughput of MessageRing for several message sizes, against plain memcpy
+// of the same data. The ring is filled and drained by a single thread, so
+// this measures the ring's own overhead rather than cross-core traffic.
+// Usage: shmCpp_bench_message_ring
+
+namespace {
+
+constexpr size_t ring_bytes {1 << 20};
+constexpr size_t total_bytes {size_t(1) << 30};
+
+using Ring = shm::MessageRing<ring_bytes>;
+
+void run(Ring& ring, size_t length) {
+    std::vector<unsigned char> src(length, 1), dst(length);
+    const auto messages {total_bytes / length};
+    uint64_t sum {0};
+
+    shmBench::Timer copy_timer;
+    for (size_t i {0}; i < messages; i++) {
+        std::memcpy(dst.data(), src.data(), length);
+        std::memcpy(src.data(), dst.data(), length);
+        shmBench::do_not_optimise(dst[0]);
+    }
+    const auto copy {copy_timer.seconds()};
+
+    shmBench::Timer ring_timer;
+    size_t sent {0};
+    size_t received {0};
+
+    while (received < messages) {
+        // Fill...
+        unsigned char* p;
+        while (sent < messages && (p = ring.try_reserve(length)) != nullptr) {
+            std::memcpy(p, src.data(), length);
+            ring.commit();
+            sent++;
+        }
+
+        // ...and drain
+        const unsigned char* q;
+        size_t n;
+        while ((q = ring.peek(n)) != nullptr) {
+            std::memcpy(dst.data(), q, n);
+            sum += dst[0];
+            ring.consume();
+            received++;
+        }
+    }
+    const auto t {ring_timer.seconds()};
+    shmBench::do_not_optimise(sum);
+
+    const auto gb {static_cast<double>(messages * length) / 1e9};
+    std::cout << length << " B messages:\tring " << gb / t << " GB/s, "
+        << t / messages * 1e9 << " ns/message\tmemcpy " << gb / copy << " GB/s\n";
+}
+
+} // namespace
+
+int main() {
+    Ring ring(shm::formatName("ShmCpp_Bench_MessageRing"));
+
+    for (const size_t length : {32, 256, 4096, 65536})
+        run(ring, length);
+}
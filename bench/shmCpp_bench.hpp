@@ -0,0 +1,123 @@
+#ifndef SHM_CPP_BENCH_H
+#define SHM_CPP_BENCH_H
+
+#include "shmCpp.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace shmBench {
+
+/** Measures elapsed wall-clock time. */
+class Timer {
+public:
+    Timer(): _start{std::chrono::steady_clock::now()} {}
+
+    /** @returns Seconds since construction. */
+    double seconds() const
+    {
+        const std::chrono::duration<double> d {std::chrono::steady_clock::now() - this->_start};
+        return d.count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point _start;
+};
+
+
+/** Counts data TLB read misses of this process, where the kernel allows it. */
+class TlbMissCounter {
+public:
+    TlbMissCounter(): fd{-1}
+    {
+#ifdef __linux__
+        perf_event_attr attr {};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB
+            | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        this->fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~TlbMissCounter()
+    {
+#ifdef __linux__
+        if (this->fd != -1)
+            close(this->fd);
+#endif
+    }
+
+    /** @returns `false` if the counter could not be opened. */
+    bool available() const
+        { return this->fd != -1; }
+
+    void start()
+    {
+#ifdef __linux__
+        if (this->fd != -1) {
+            ioctl(this->fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(this->fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    /** @returns The number of misses since @ref start. */
+    uint64_t stop()
+    {
+        uint64_t n {0};
+#ifdef __linux__
+        if (this->fd != -1) {
+            ioctl(this->fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(this->fd, &n, sizeof(n)) != sizeof(n))
+                n = 0;
+        }
+#endif
+        return n;
+    }
+
+private:
+    int fd;
+};
+
+
+/** Fast pseudo-random number generator (xorshift64). */
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 88172645463325252ull): state{seed} {}
+
+    uint64_t operator()()
+    {
+        this->state ^= this->state << 13;
+        this->state ^= this->state >> 7;
+        this->state ^= this->state << 17;
+        return this->state;
+    }
+
+private:
+    uint64_t state;
+};
+
+/** Stops the compiler from optimising away a computed value. */
+template<class Tp>
+inline void do_not_optimise(const Tp& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace shmBench
+
+#endif
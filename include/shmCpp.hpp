@@ -2,16 +2,43 @@
 #define SHM_CPP_H
 
 #include <fcntl.h>
+#include <pthread.h>
 #include <sys/shm.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
+#include <sys/socket.h>
 #include <unistd.h>
 #include <limits.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sys/vfs.h>
+#endif
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <string>
+#include <thread>
 #include <stdexcept>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 /** Namespace encapsulating the shmCpp library. */
 namespace shm {
@@ -28,6 +55,24 @@ class MemoryError : public std::runtime_error {
     using std::runtime_error::runtime_error;
 };
 
+/** Errors concerning the layout of the data in shared memory, e.g. a
+ * different type or version on the other side. */
+class LayoutError : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+/** Errors concerning locking, e.g. a @ref Mutex left unusable after its
+ * holder died. */
+class LockError : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+
+/** Assumed size of a CPU cache line.
+ * Fields of shared structures that are written by different processes are
+ * kept this far apart to avoid false sharing. */
+static constexpr size_t _cache_line_size {64};
+
 
 /** Enumeration of access permissions/modes for shared memory. */
 enum class Permissions
@@ -39,33 +84,360 @@ enum class Permissions
 };
 
 
+/** Enumeration of the kinds of storage backing shared memory. */
+enum class Backend
+{
+    /** A named POSIX shared memory object (`shm_open`). */
+    PosixShm,
+    /** A System V shared memory segment (`shmget`/`shmat`), keyed by a hash
+     * of the name. Segments cannot be resized once created. Explicit huge
+     * pages use `SHM_HUGETLB`. */
+    SysV,
+    /** An anonymous file created with `memfd_create` (Linux only). It has no
+     * name, so it never needs removing and cannot leak; other processes
+     * attach to it through a file descriptor, e.g. passed with
+     * @ref sendDescriptor. The name given is only a label for debugging. */
+    Memfd,
+    /** An anonymous shared mapping (`MAP_SHARED | MAP_ANONYMOUS`), with no
+     * file at all. Processes `fork`ed after the object is constructed inherit
+     * the handle and the mapping, and use them without any system calls. */
+    Anonymous,
+    /** A regular file, whose path is the name. On a disk-backed filesystem
+     * the data outlives reboots. */
+    File
+};
+
+
+/** @returns `true` if memory of the @a backend kind has a name, which other
+ * processes can use to attach to it and which may need removing. */
+constexpr bool _is_named(Backend backend) {
+    return backend == Backend::PosixShm || backend == Backend::SysV
+        || backend == Backend::File;
+}
+
+
+/** Enumeration of ways to open shared memory.
+ * Read-only objects always use @ref OpenMode::Open: only writers create. */
+enum class OpenMode
+{
+    /** Create the shared memory, failing if it already exists. */
+    Create,
+    /** Attach to existing shared memory, failing if it does not exist or is
+     * too small. Never resizes it. */
+    Open,
+    /** Attach to the shared memory if it exists, otherwise create it. Grows
+     * existing shared memory that is too small, but never shrinks it. */
+    CreateOrOpen
+};
+
+
+/** Enumeration of policies for removing the name of shared memory.
+ * Copies of an object inherited by a forked child never remove it. */
+enum class Lifetime
+{
+    /** The object that created the shared memory removes it when destroyed. */
+    Owner,
+    /** The shared memory is never removed, and persists until it is removed
+     * by other means, or the system is restarted. */
+    Persistent,
+    /** The last writable object attached to the shared memory (with this
+     * policy) removes it. Read-only objects are not counted, and never remove
+     * it, as they cannot write to the attach count. */
+    LastDetacher
+};
+
+
+/** Enumeration of huge page modes for shared memory. */
+enum class HugePages
+{
+    /** Use the system's default page size. */
+    None,
+    /** Ask the kernel to back the mapping with transparent huge pages, via
+     * `madvise(MADV_HUGEPAGE)`. Whether it does depends on the system's
+     * `shmem_enabled` setting. */
+    Transparent,
+    /** Back the memory with a file on a hugetlbfs mount, falling back to
+     * @ref Transparent if that is not possible (no mount, no free huge
+     * pages, ...). */
+    Explicit
+};
+
+
+/** Enumeration of ways to write mapped data back to its backing file. */
+enum class Flush
+{
+    /** Start writing back, and return immediately (`MS_ASYNC`). */
+    Async,
+    /** Return once the data is on disk (`MS_SYNC`). */
+    Sync
+};
+
+
+/** Options controlling how a shared memory object is opened and mapped.
+ * The defaults match the behaviour of a plain POSIX shared memory object. */
+struct Options {
+    /** The kind of storage to use. */
+    Backend backend {Backend::PosixShm};
+
+    /** Seal the size of a new @ref Backend::Memfd file (`F_SEAL_SHRINK`,
+     * `F_SEAL_GROW` and `F_SEAL_SEAL`), so that processes attaching to it can
+     * trust its size for good. */
+    bool seal {true};
+
+    /** Whether to create the shared memory, attach to it, or either.
+     * Attaching with read-only permissions opens and maps it read-only. */
+    OpenMode open_mode {OpenMode::CreateOrOpen};
+
+    /** When to remove the shared memory's name. Objects already attached
+     * keep their mapping when it is removed, but new ones cannot attach. */
+    Lifetime lifetime {Lifetime::Owner};
+
+    /** Huge page mode. Sizes are rounded up to a whole number of huge pages
+     * in any mode other than @ref HugePages::None. */
+    HugePages huge_pages {HugePages::None};
+
+    /** Mount point of the hugetlbfs used by @ref HugePages::Explicit. */
+    std::string hugetlbfs_path {"/dev/hugepages"};
+
+    /** Prefault the whole mapping when it is created, with `MAP_POPULATE`
+     * (Linux only), so that first accesses do not take page faults. */
+    bool populate {false};
+
+    /** If non-zero, touch every page of the mapping from this many threads
+     * after mapping it. Works on every platform, and in parallel. */
+    unsigned pretouch_threads {0};
+
+    /** Lock the mapping into RAM with `mlock`, so it is never paged out.
+     * Subject to `RLIMIT_MEMLOCK`. */
+    bool lock {false};
+
+    /** If non-zero, a background thread writes dirty pages back to the
+     * backing file this often (`msync(MS_ASYNC)`). Only useful with
+     * @ref Backend::File. */
+    std::chrono::milliseconds flush_interval {0};
+
+    /** Check, once when attaching, that the shared memory holds data of the
+     * same layout (size and alignment of the type, number of elements and
+     * @ref layout_version) as this process expects. The first writable
+     * handle to check stamps the layout into the segment header.
+     * @throws LayoutError on a mismatch. */
+    bool check_layout {false};
+
+    /** Version of the data layout, for changes @ref check_layout cannot
+     * detect by itself. */
+    uint32_t layout_version {0};
+
+    /** Map the data twice, back to back in virtual memory, so that any run
+     * of up to the data's size is contiguous even across its end (see
+     * @ref MirroredArray). The data must be a multiple of the page size, and
+     * starts on its own page, so every handle to the shared memory must use
+     * this option. Needs a backend with a file descriptor (not
+     * @ref Backend::SysV or @ref Backend::Anonymous), and disables huge
+     * pages. */
+    bool mirror {false};
+};
+
+
+/** Backend policy that takes the backend from @ref Options::backend, so it
+ * can be chosen at run time. */
+struct OptionsBackend {
+    static Options configure(const Options& opts)
+        { return opts; }
+};
+
+/** Backend policy that fixes the backend at compile time, overriding
+ * @ref Options::backend. Given as the last template parameter of
+ * @ref Object and @ref Array, e.g. `shm::Array<int, 10, shm::MemfdBackend>`. */
+template<Backend B>
+struct BackendPolicy {
+    static Options configure(Options opts)
+        { opts.backend = B; return opts; }
+};
+
+using PosixShmBackend = BackendPolicy<Backend::PosixShm>;
+using SysVBackend = BackendPolicy<Backend::SysV>;
+using MemfdBackend = BackendPolicy<Backend::Memfd>;
+using AnonymousBackend = BackendPolicy<Backend::Anonymous>;
+using FileBackend = BackendPolicy<Backend::File>;
+
+
+/** Control block at the start of every shared memory object.
+ * The user data follows it, aligned to a cache line. */
+struct _SegmentHeader {
+    /** Counts calls to @ref notify. Also used as the futex word that
+     * @ref wait blocks on. */
+    alignas(_cache_line_size) std::atomic<uint32_t> change_seq;
+
+    /** The number of writable objects attached with
+     * @ref Lifetime::LastDetacher, or @ref detached once the last of them has
+     * gone and the SMO is being removed. */
+    std::atomic<uint32_t> attach_count;
+
+    /** Value of @ref attach_count for a SMO that is being removed. */
+    enum : uint32_t { detached = UINT32_MAX };
+
+    /** The largest number of user data bytes requested by a writer. Less
+     * than the mapped size if that was rounded up. */
+    std::atomic<uint64_t> data_size;
+
+    /** @ref _segment_magic once the layout has been stamped. */
+    std::atomic<uint32_t> magic;
+
+    /** Whether the layout has been stamped. */
+    std::atomic<uint32_t> layout_state;
+    enum : uint32_t { unstamped = 0, stamping = 1, ready = 2 };
+
+    /** Fingerprint of the layout of the data, for @ref Options::check_layout. */
+    std::atomic<uint64_t> layout;
+
+    /** Whether the data has been constructed in place, see
+     * @ref begin_construction. */
+    std::atomic<uint32_t> init_state;
+    enum : uint32_t { uninit = 0, constructing = 1, constructed = 2 };
+
+    /** Claims the right to construct the data, waiting for any other
+     * process that is constructing it.
+     * @returns `true` if the caller must construct the data and then call
+     * @ref end_construction, or `false` if it is already constructed. */
+    inline bool begin_construction() noexcept;
+
+    /** Publishes the data constructed after @ref begin_construction, or on
+     * failure (@a success `false`) lets another process try instead. */
+    inline void end_construction(bool success) noexcept;
+
+    /** Blocks until the data has been constructed. */
+    inline void wait_constructed() const noexcept;
+
+    /** Records a change and wakes every process blocked in @ref wait.
+     * Issues one system call. */
+    inline void notify() noexcept;
+
+    /** Blocks until @ref change_seq differs from @a seen, then updates
+     * @a seen to the new value.
+     * @param seen The last value of @ref change_seq observed by the caller.
+     * @param spins The number of times to poll before sleeping.
+     * @param timeout If not `nullptr`, the maximum time to wait for.
+     * @returns `false` if the wait timed out. */
+    inline bool wait(uint32_t& seen, unsigned spins,
+        const std::chrono::nanoseconds* timeout) const noexcept;
+};
+
+static_assert(sizeof(_SegmentHeader) == _cache_line_size,
+    "Segment header must occupy exactly one cache line");
+
+
+/** Magic number identifying a stamped segment header ("shmC"). */
+static constexpr uint32_t _segment_magic {0x73686d43};
+
+/** Step of the FNV-1a hash, over a whole value. */
+constexpr uint64_t _fnv_mix(uint64_t hash, uint64_t value) {
+    return (hash ^ value) * 1099511628211ull;
+}
+
+/** @returns A fingerprint of the layout of @a count objects of type @a Tp,
+ * computed at compile time. */
+template<class Tp>
+constexpr uint64_t _layout_of(size_t count = 1) {
+    return _fnv_mix(_fnv_mix(_fnv_mix(14695981039346656037ull, sizeof(Tp)), alignof(Tp)), count);
+}
+
+
 /** Shared memory object class.
  * This manages the shared memory from the OS' perspective.
- * @param Sz The number of bytes to store in the shared memory. Must be
- * greater than zero.
+ * The size is a run-time value so that a single (non-template) implementation
+ * serves every typed wrapper.
  */
-template<size_t Sz>
 class _SharedMemoryObject {
 public:
-    // Assert size is acceptable is ok
-    static_assert(Sz > 0, "Cannot create shared memory object with size 0");
-
     /** Constructor.
-     * Opens the SMO, creating it if it does not already exist, and sizes it.
+     * Opens the SMO as set by @ref Options::open_mode (by default, creating
+     * it if it does not already exist), and sizes it to hold a
+     * @ref _SegmentHeader followed by @a size bytes.
      * @param name The name/identifier of the POSIX shared memory object.
+     * @param size The number of bytes to store in the shared memory. If zero,
+     * the SMO must already exist, and its size is discovered from it.
+     * @param opts Options controlling how the SMO is opened and mapped.
      * @note It is advised to use @ref formatName on the name used.
      * @note If the SMO already exists and its size is larger than that
      * specified, the data past the end of the new length in the existing SMO
      * will be lost or corrupted. */
-    _SharedMemoryObject(const std::string& name, Permissions perm);
+    _SharedMemoryObject(const std::string& name, size_t size, Permissions perm,
+        const Options& opts = Options());
+
+    /** Constructor.
+     * Maps the shared memory referred to by the file descriptor @a fd, e.g.
+     * one received with @ref receiveDescriptor. The descriptor is duplicated;
+     * the caller keeps ownership of @a fd.
+     * @param size The number of bytes expected. If zero, the size is
+     * discovered from the shared memory. The shared memory is never resized. */
+    _SharedMemoryObject(int fd, size_t size, Permissions perm,
+        const Options& opts = Options());
 
     virtual ~_SharedMemoryObject();
 
-    /** @returns A pointer to the mapped data. */
+    /** A mapping is owned by every handle that @ref acquire gave it to, and
+     * is never copied or moved. */
+    _SharedMemoryObject(const _SharedMemoryObject&) = delete;
+    _SharedMemoryObject& operator=(const _SharedMemoryObject&) = delete;
+
+    /** Returns a mapping of the SMO called @a name, with the same arguments
+     * as the constructor.
+     * If this process already has a mapping of the SMO with the same
+     * permissions, at least @a size bytes, and the same options affecting
+     * the mapping (all but @ref Options::open_mode and the layout check),
+     * that mapping is shared rather
+     * than the SMO being opened and mapped again. The mapping is released
+     * when the last handle to it is destroyed.
+     * @param layout The fingerprint of the data's layout (see @ref _layout_of),
+     * checked if requested in @a opts. */
+    static std::shared_ptr<_SharedMemoryObject> acquire(const std::string& name,
+        size_t size, Permissions perm, const Options& opts = Options(), uint64_t layout = 0);
+    /** Returns a new mapping of the shared memory referred to by @a fd. */
+    static std::shared_ptr<_SharedMemoryObject> acquire(int fd,
+        size_t size, Permissions perm, const Options& opts = Options(), uint64_t layout = 0);
+
+    /** @returns A pointer to the mapped data, after the header. */
     inline void* get()
-        { return this->_data; }
+        { return static_cast<char*>(this->_data) + this->_data_offset; }
     inline const void* get() const
-        { return this->_data; }
+        { return static_cast<const char*>(this->_data) + this->_data_offset; }
+
+    /** @returns The control block at the start of the mapping. */
+    inline _SegmentHeader& header()
+        { return *static_cast<_SegmentHeader*>(this->_data); }
+    inline const _SegmentHeader& header() const
+        { return *static_cast<const _SegmentHeader*>(this->_data); }
+
+    /** @returns The number of bytes available through @ref get. */
+    inline size_t size() const noexcept
+        { return this->_data_size; }
+
+    /** @returns The huge page mode actually in effect for the mapping. */
+    inline HugePages huge_pages() const noexcept
+        { return this->_huge_pages; }
+
+    /** @returns A file descriptor referring to the shared memory, which can
+     * be passed to other processes, or -1 if the descriptor was closed after
+     * mapping (as it is for @ref Backend::PosixShm). Owned by this object. */
+    inline int descriptor() const noexcept
+        { return this->fd; }
+
+    /** @returns `true` if the size of the shared memory is sealed, so can
+     * never shrink under the mapping. */
+    inline bool is_sealed() const noexcept
+        { return this->_sealed; }
+
+    /** Writes the pages overlapping [@a begin, @a end) back to the backing
+     * file. The range is widened to whole pages.
+     * @throws MemoryError if `msync` fails. */
+    void flush(const void* begin, const void* end, Flush mode);
+
+    /** @returns The time spent prefaulting and locking the mapping, as
+     * requested by @ref Options::populate, @ref Options::pretouch_threads
+     * and @ref Options::lock. Opening, sizing and (without
+     * @ref Options::populate) mapping the SMO are not included. */
+    inline std::chrono::nanoseconds prefault_time() const noexcept
+        { return this->_prefault_time; }
 
     /** @returns the name used to open the shared memory. */
     inline const std::string& name() const noexcept
@@ -79,11 +451,80 @@ public:
     inline bool is_writable() const noexcept
         { return this->_perm != Permissions::ReadOnly; }
 
+    /** @throws FileError naming @a operation if the object is read-only, as
+     * writing through its mapping would fault. */
+    void check_writable(const char* operation) const;
+
 private:
-    /** Opens a SMO.
-     * Writes to @ref fd. */
+    /** Attaches to and maps the shared memory, prefaults it if requested,
+     * and records or discovers the size of its data.
+     * @param size The size of the data given to the constructor. */
+    void init(size_t size);
+
+    /** Opens and maps the SMO, and registers with its attach count if
+     * required by @ref Options::lifetime.
+     * @returns `false`, having released everything, if the SMO was found
+     * to be in the middle of being removed. */
+    bool attach();
+
+    /** Deregisters from the SMO's attach count.
+     * @returns `true` if this was the last registered object. */
+    bool detach();
+
+    /** Creates, sizes, maps and (if requested) seals a memfd. */
+    void open_memfd();
+
+    /** Checks the descriptor given to the constructor, and discovers its
+     * size if it is not yet known. */
+    void open_descriptor();
+
+    /** Does the work of @ref acquire, apart from checking the layout. */
+    static std::shared_ptr<_SharedMemoryObject> find_or_map(const std::string& name,
+        size_t size, Permissions perm, const Options& opts);
+
+    /** Stamps @a layout into the header if it is unstamped, or checks that
+     * it matches the stamped one.
+     * @throws LayoutError on a mismatch, or if no writer stamps the header
+     * in time. */
+    void check_layout(uint64_t layout);
+
+    /** Creates an anonymous shared mapping. */
+    void map_anonymous();
+
+    /** Seals the size of the memfd, if requested in @ref _opts. */
+    void seal();
+
+    /** @returns `true` if the shared memory has a name, which may need
+     * removing. */
+    inline bool is_named() const noexcept
+        { return !this->_from_descriptor && _is_named(this->_opts.backend); }
+
+    /** Opens a SMO, creating and/or attaching to it according to
+     * @ref Options::open_mode.
+     * Writes to @ref fd, and to @ref _size if it is not yet known. */
     void open();
 
+    /** Creates and/or attaches to the System V segment, according to
+     * @ref Options::open_mode. Writes to @ref _sysv_id and @ref _size. */
+    void open_sysv();
+
+    /** Attaches the System V segment at @ref _data. */
+    void map_sysv();
+
+    /** Opens the POSIX SMO or, if set, the file at @ref _path. */
+    int open_fd(int oflag, mode_t mode) const;
+
+    /** Throws a @ref FileError describing a failure to open the SMO. */
+    [[noreturn]] void throw_open_error() const;
+
+    /** Sets the size of the open SMO to @ref _size. */
+    void resize();
+
+    /** Opens, sizes and maps a file on the hugetlbfs at @a mount.
+     * @returns `false`, having released anything it acquired, if any step
+     * fails. */
+    bool open_hugetlbfs(const std::string& mount);
+
     /** Closes the underlying file without unlinking the memory object. */
     void close();
 
@@ -95,6 +536,22 @@ private:
     /** Maps the shared memory to @ref _data. */
     void map();
 
+    /** Maps the header page and data, then the data again straight after. */
+    void map_mirrored();
+
+    /** @returns The number of bytes of address space mapped. */
+    inline size_t mapped_size() const noexcept
+        { return this->_opts.mirror ? 2 * this->_size - this->_data_offset : this->_size; }
+
+    /** Touches and/or locks the mapped pages, as requested in @ref _opts. */
+    void prefault();
+
+    /** Starts the thread requested by @ref Options::flush_interval. */
+    void start_flusher();
+
+    /** Stops the thread started by @ref start_flusher, if any. */
+    void stop_flusher();
+
     /** Unmaps the shared memory from @ref _data. */
     void unmap();
 
@@ -107,13 +564,63 @@ private:
     /** Shared memory object's permission. */
     Permissions _perm;
 
+    /** Offset of the user data: the size of the header, or a whole page if
+     * the data is mirrored. */
+    const size_t _data_offset;
+
+    /** Total number of bytes of the SMO, including the header.
+     * Zero until discovered if the size was not given. */
+    size_t _size;
+
+    /** Number of user data bytes. */
+    size_t _data_size;
+
+    /** Huge page mode in effect. */
+    HugePages _huge_pages;
+
+    /** Path of the file backing the SMO, if it is on a hugetlbfs or uses
+     * @ref Backend::File. */
+    std::string _path;
+
+    /** Options the SMO was opened with. */
+    const Options _opts;
+
+    /** Whether this object created the SMO. */
+    bool _created;
+
+    /** Whether this object is registered in the SMO's attach count. */
+    bool _counted;
+
+    /** Process that opened the SMO. A child forked after it inherits the
+     * mapping, but neither created the SMO nor is in its attach count. */
+    pid_t _pid;
+
+    /** Whether the shared memory was given as a file descriptor. */
+    bool _from_descriptor;
+
+    /** Whether the shared memory's size is sealed. */
+    bool _sealed;
+
+    /** Identifier of the System V segment, or -1 for other backends. */
+    int _sysv_id;
+
+    /** Background flusher, and its means of stopping. */
+    std::thread _flusher;
+    std::mutex _flusher_mutex;
+    std::condition_variable _flusher_cv;
+    bool _flusher_stop;
+
+    /** Time spent in @ref prefault and populating the mapping. */
+    std::chrono::nanoseconds _prefault_time;
+
     /** File descriptor for the SMO. */
     int fd;
 };
 
 
-/** Class for creating and manipulating a POSIX shared memory object (SMO). */
-template<class Tp>
+/** Class for creating and manipulating a POSIX shared memory object (SMO).
+ * @tparam Storage The backend policy, e.g. @ref SysVBackend. */
+template<class Tp, class Storage = OptionsBackend>
 class Object {
 public:
     /** Constructor.
@@ -121,13 +628,34 @@ public:
      * @param name The name/identifier of the POSIX shared memory object.
      * @note It is advised to use @ref formatName on the name used.
      * @note If the SMO already exists and the types of this and the other
-     * `shm::Object` are not the same size, the data may be corrupted. */
-    Object(const std::string& name, Permissions perm = Permissions::ReadWrite):
-    _obj{_SharedMemoryObject<sizeof(Tp)>(name, perm)}
+     * `shm::Object` are not the same size, the data may be corrupted.
+     * @ref Options::check_layout detects this.
+     * @throws LayoutError if requested checks of the layout fail. */
+    Object(const std::string& name, Permissions perm = Permissions::ReadWrite,
+        const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(name, sizeof(Tp), perm, Storage::configure(opts),
+        _layout_of<Tp>())},
+    _seen{_obj->header().change_seq.load(std::memory_order_acquire)}
+    {}
+
+    /** Constructor.
+     * Maps the shared memory referred to by @a fd, e.g. one received with
+     * @ref receiveDescriptor. The caller keeps ownership of @a fd.
+     * @throws FileError if the shared memory is too small. */
+    Object(int fd, Permissions perm = Permissions::ReadWrite,
+        const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(fd, sizeof(Tp), perm, opts, _layout_of<Tp>())},
+    _seen{_obj->header().change_seq.load(std::memory_order_acquire)}
     {}
 
     ~Object() = default;
 
+    /** Handles are move-only. A moved-from handle must not be used. */
+    Object(Object&&) = default;
+    Object& operator=(Object&&) = default;
+    Object(const Object&) = delete;
+    Object& operator=(const Object&) = delete;
+
     /** Object access. */
     inline operator Tp&() noexcept
         { return *this->get_typed(); }
@@ -146,7 +674,74 @@ public:
     inline Object& operator=(const Tp& obj)
         { *this->get_typed() = obj; return *this; }
     inline Object& operator=(Tp&& obj)
-        { *this->get_typed() = obj; return *this; }
+        { *this->get_typed() = std::move(obj); return *this; }
+
+    /** In-place construction.
+     * Constructs the object from @a args with placement new, exactly once
+     * across every process attached to the SMO: other callers wait (without
+     * touching the object) until it is constructed, then return it as-is.
+     * If the constructor throws, the next caller constructs it instead.
+     * The destructor is never run.
+     * @note A process that dies while constructing leaves every other
+     * caller waiting.
+     * @returns The constructed object.
+     * @throws FileError if the object is read-only. */
+    template<class... Args>
+    Tp& emplace(Args&&... args)
+    {
+        this->_obj->check_writable("construct the object");
+        auto& header {this->_obj->header()};
+
+        if (header.begin_construction()) {
+            try {
+                ::new (static_cast<void*>(this->get_typed())) Tp(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                header.end_construction(false);
+                throw;
+            }
+            header.end_construction(true);
+        }
+
+        return *this->get_typed();
+    }
+
+    /** Blocks until another handle has constructed the object with
+     * @ref emplace. Works with read-only handles. */
+    inline void wait_constructed() const noexcept
+        { this->_obj->header().wait_constructed(); }
+
+    /** @returns `true` if the object has been constructed with @ref emplace. */
+    inline bool is_constructed() const noexcept
+    {
+        return this->_obj->header().init_state.load(std::memory_order_acquire)
+            == _SegmentHeader::constructed;
+    }
+
+    /** Change notification.
+     * A writer calls @ref notify after modifying the object; readers block in
+     * @ref wait_for_change instead of polling it. Re-check the object before
+     * each wait: a change made after this handle was constructed, or after
+     * its last wait returned, ends the next wait immediately.
+     * @note @ref notify requires write permissions. */
+    inline void notify() noexcept
+        { this->_obj->header().notify(); }
+    /** Blocks until @ref notify is called on any handle to this SMO.
+     * @param spins The number of times to poll before sleeping; non-zero
+     * values trade CPU time for lower wake-up latency. */
+    inline void wait_for_change(unsigned spins = 0) noexcept
+        { this->_obj->header().wait(this->_seen, spins, nullptr); }
+    /** As above, but gives up after @a timeout.
+     * @returns `false` if the wait timed out. */
+    template<class Rep, class Period>
+    inline bool wait_for_change(
+        const std::chrono::duration<Rep, Period>& timeout, unsigned spins = 0) noexcept
+    {
+        const std::chrono::nanoseconds t {
+            std::chrono::duration_cast<std::chrono::nanoseconds>(timeout)
+        };
+        return this->_obj->header().wait(this->_seen, spins, &t);
+    }
 
     /** Direct access to the mapped memory. */
     inline Tp* data() noexcept
@@ -154,20 +749,41 @@ public:
     inline const Tp* data() const noexcept
         { return this->get_typed(); }
 
+    /** @returns The time the constructor spent prefaulting and locking the
+     * mapping. */
+    inline std::chrono::nanoseconds prefault_time() const noexcept
+        { return this->_obj->prefault_time(); }
+
+    /** Writes the object back to its backing file.
+     * @see Options::flush_interval for periodic flushing. */
+    inline void flush(Flush mode = Flush::Sync)
+        { this->_obj->flush(this->data(), this->data() + 1, mode); }
+
+    /** @returns A file descriptor that can be passed to other processes
+     * with @ref sendDescriptor, or -1 if the backend does not keep one. */
+    inline int descriptor() const noexcept
+        { return this->_obj->descriptor(); }
+
 private:
     inline Tp* get_typed()
-        { return static_cast<Tp*>(this->_obj.get()); }
+        { return static_cast<Tp*>(this->_obj->get()); }
     inline const Tp* get_typed() const
-        { return static_cast<const Tp*>(this->_obj.get()); }
+        { return static_cast<const Tp*>(this->_obj->get()); }
+
+    std::shared_ptr<_SharedMemoryObject> _obj;
 
-    _SharedMemoryObject<sizeof(Tp)> _obj;
+    /** Last change sequence observed by @ref wait_for_change. */
+    uint32_t _seen;
 };
 
 
-/** Class for creating and manipulating a POSIX shared memory object (SMO) array. */
-template<class Tp, size_t Sz>
+/** Class for creating and manipulating a POSIX shared memory object (SMO) array.
+ * @tparam Storage The backend policy, e.g. @ref SysVBackend. */
+template<class Tp, size_t Sz, class Storage = OptionsBackend>
 class Array {
 public:
+    static_assert(Sz > 0, "Cannot create shared memory array with size 0");
+
     /** Constructor.
      * Opens the SMO, creating it if it does not already exist.
      * @param name The name/identifier of the POSIX shared memory object.
@@ -175,12 +791,31 @@ public:
      * @note If the SMO already exists and its size is larger than that
      * specified, the data past the end of the new length in the existing SMO
      * will be lost. */
-    Array(const std::string& name, Permissions perm = Permissions::ReadWrite):
-    _obj{_SharedMemoryObject<sizeof(Tp) * Sz>(name, perm)}
+    Array(const std::string& name, Permissions perm = Permissions::ReadWrite,
+        const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(name, sizeof(Tp) * Sz, perm, Storage::configure(opts),
+        _layout_of<Tp>(Sz))},
+    _seen{_obj->header().change_seq.load(std::memory_order_acquire)}
+    {}
+
+    /** Constructor.
+     * Maps the shared memory referred to by @a fd, e.g. one received with
+     * @ref receiveDescriptor. The caller keeps ownership of @a fd.
+     * @throws FileError if the shared memory is too small. */
+    Array(int fd, Permissions perm = Permissions::ReadWrite,
+        const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(fd, sizeof(Tp) * Sz, perm, opts, _layout_of<Tp>(Sz))},
+    _seen{_obj->header().change_seq.load(std::memory_order_acquire)}
     {}
 
     ~Array() = default;
 
+    /** Handles are move-only. A moved-from handle must not be used. */
+    Array(Array&&) = default;
+    Array& operator=(Array&&) = default;
+    Array(const Array&) = delete;
+    Array& operator=(const Array&) = delete;
+
     /** Element access. */
     inline Tp& operator[](size_t n) noexcept
         { return this->get_typed()[n]; }
@@ -211,6 +846,30 @@ public:
     constexpr size_t size() const noexcept
         { return Sz; }
 
+    /** @returns The huge page mode actually in effect, which may be weaker
+     * than the one requested. */
+    inline HugePages huge_pages() const noexcept
+        { return this->_obj->huge_pages(); }
+
+    /** Writes the elements in [@a first, @a last) back to the backing file.
+     * The range is widened to whole pages.
+     * @see Options::flush_interval for periodic flushing. */
+    inline void flush(const Tp* first, const Tp* last, Flush mode = Flush::Sync)
+        { this->_obj->flush(first, last, mode); }
+    /** Writes every element back to the backing file. */
+    inline void flush(Flush mode = Flush::Sync)
+        { this->flush(this->begin(), this->end(), mode); }
+
+    /** @returns A file descriptor that can be passed to other processes
+     * with @ref sendDescriptor, or -1 if the backend does not keep one. */
+    inline int descriptor() const noexcept
+        { return this->_obj->descriptor(); }
+
+    /** @returns The time the constructor spent prefaulting and locking the
+     * mapping. */
+    inline std::chrono::nanoseconds prefault_time() const noexcept
+        { return this->_obj->prefault_time(); }
+
     /** Direct access to the mapped memory. */
     inline Tp* data() noexcept
         { return this->get_typed(); }
@@ -233,259 +892,4295 @@ public:
     inline const Tp* cend() const
         { return this->data() + this->size(); }
 
+    /** Change notification.
+     * A writer calls @ref notify after modifying the array; readers block in
+     * @ref wait_for_change instead of polling it. Re-check the array before
+     * each wait: a change made after this handle was constructed, or after
+     * its last wait returned, ends the next wait immediately.
+     * @note @ref notify requires write permissions. */
+    inline void notify() noexcept
+        { this->_obj->header().notify(); }
+    /** Blocks until @ref notify is called on any handle to this SMO.
+     * @param spins The number of times to poll before sleeping; non-zero
+     * values trade CPU time for lower wake-up latency. */
+    inline void wait_for_change(unsigned spins = 0) noexcept
+        { this->_obj->header().wait(this->_seen, spins, nullptr); }
+    /** As above, but gives up after @a timeout.
+     * @returns `false` if the wait timed out. */
+    template<class Rep, class Period>
+    inline bool wait_for_change(
+        const std::chrono::duration<Rep, Period>& timeout, unsigned spins = 0) noexcept
+    {
+        const std::chrono::nanoseconds t {
+            std::chrono::duration_cast<std::chrono::nanoseconds>(timeout)
+        };
+        return this->_obj->header().wait(this->_seen, spins, &t);
+    }
+
 private:
     inline Tp* get_typed()
-        { return static_cast<Tp*>(this->_obj.get()); }
+        { return static_cast<Tp*>(this->_obj->get()); }
     inline const Tp* get_typed() const
-        { return static_cast<const Tp*>(this->_obj.get()); }
-
-    _SharedMemoryObject<sizeof(Tp) * Sz> _obj;
-};
+        { return static_cast<const Tp*>(this->_obj->get()); }
 
+    std::shared_ptr<_SharedMemoryObject> _obj;
 
-/** Tests whether a SMO called @a name exists.
- * @note This test will also fail if the memory fails to open for reasons such
- * as process- or system-wide limits on file openings being reached. */
-static bool exists(const std::string& name);
+    /** Last change sequence observed by @ref wait_for_change. */
+    uint32_t _seen;
+};
 
-/** Formats the identifier name according to the naming conventions outlined at
- * https://www.man7.org/linux/man-pages/man3/shm_open.3.html#DESCRIPTION. */
-static std::string formatName(const std::string& name);
+/** Class for creating and manipulating a POSIX shared memory object (SMO)
+ * array whose size is only known at run time.
+ * The counterpart of @ref Array for sizes that come from configuration. */
+template<class Tp>
+class DynArray {
+public:
+    /** Constructor.
+     * Opens the SMO, creating it if it does not already exist.
+     * @param name The name/identifier of the POSIX shared memory object.
+     * @param n The number of elements. Must be greater than zero.
+     * @note It is advised to use @ref formatName on the name used.
+     * @note If the SMO already exists and its size is larger than that
+     * specified, the data past the end of the new length in the existing SMO
+     * will be lost. */
+    DynArray(const std::string& name, size_t n, Permissions perm = Permissions::ReadWrite,
+        const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(name, sizeof(Tp) * DynArray::checked_count(n), perm, opts,
+        _layout_of<Tp>(0))},
+    _size{n},
+    _seen{_obj->header().change_seq.load(std::memory_order_acquire)}
+    {}
 
-} // namespace shm
+    /** Constructor.
+     * Attaches to an existing SMO, taking the number of elements from its
+     * size.
+     * @param name The name/identifier of the POSIX shared memory object.
+     * @throws FileError if the SMO does not exist. */
+    DynArray(const std::string& name, Permissions perm = Permissions::ReadWrite,
+        const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(name, 0, perm, opts, _layout_of<Tp>(0))},
+    _size{_obj->size() / sizeof(Tp)},
+    _seen{_obj->header().change_seq.load(std::memory_order_acquire)}
+    {}
 
-// END OF API HEADER
-////////////////////////////////////////////////////////////////////////////////
-// START OF IMPLEMENTATION
+    /** Constructor.
+     * Maps the shared memory referred to by @a fd, e.g. one received with
+     * @ref receiveDescriptor, taking the number of elements from its size.
+     * The caller keeps ownership of @a fd. */
+    DynArray(int fd, Permissions perm = Permissions::ReadWrite,
+        const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(fd, 0, perm, opts, _layout_of<Tp>(0))},
+    _size{_obj->size() / sizeof(Tp)},
+    _seen{_obj->header().change_seq.load(std::memory_order_acquire)}
+    {}
 
-namespace shm {
+    ~DynArray() = default;
 
-// class _SharedMemoryObject
+    /** Handles are move-only. A moved-from handle must not be used. */
+    DynArray(DynArray&&) = default;
+    DynArray& operator=(DynArray&&) = default;
+    DynArray(const DynArray&) = delete;
+    DynArray& operator=(const DynArray&) = delete;
 
-template<size_t Sz>
-_SharedMemoryObject<Sz>::_SharedMemoryObject(const std::string& nm, Permissions perm):
-_data{nullptr},
-_name{nm},
-_perm{perm},
-fd{-1}
-{
-    this->open();
-    this->map();
-    this->close();
-}
+    /** Element access. */
+    inline Tp& operator[](size_t n) noexcept
+        { return this->get_typed()[n]; }
+    inline const Tp& operator[](size_t n) const noexcept
+        { return this->get_typed()[n]; }
 
-template<size_t Sz>
-_SharedMemoryObject<Sz>::~_SharedMemoryObject() {
-    this->unmap();
-    this->unlink();
-}
+    /** Bounds-checked element access. */
+    inline Tp& at(size_t n)
+    {
+        if (n >= this->_size)
+            throw std::out_of_range(
+                "Shared memory: tried to access element " + std::to_string(n) +
+                ", size = " + std::to_string(this->_size)
+            );
+        return (*this)[n];
+    }
+    inline const Tp& at(size_t n) const
+    {
+        if (n >= this->_size)
+            throw std::out_of_range(
+                "Shared memory: tried to access element " + std::to_string(n) +
+                ", size = " + std::to_string(this->_size)
+            );
+        return (*this)[n];
+    }
 
-template<size_t Sz>
-void _SharedMemoryObject<Sz>::open() {
-    const auto oflag {O_RDWR | O_CREAT};
-    const mode_t mode {S_IRWXU | S_IRGRP};
+    /** @returns The number of @ref Tp objects in the DynArray. */
+    inline size_t size() const noexcept
+        { return this->_size; }
 
-    this->fd = shm_open(this->_name.c_str(), oflag, mode);
+    /** @returns The huge page mode actually in effect, which may be weaker
+     * than the one requested. */
+    inline HugePages huge_pages() const noexcept
+        { return this->_obj->huge_pages(); }
 
-    if (this->fd == -1) {
-        // error handling
-        std::string msg {"Shared memory: could not open " + this->_name};
+    /** Writes the elements in [@a first, @a last) back to the backing file.
+     * The range is widened to whole pages.
+     * @see Options::flush_interval for periodic flushing. */
+    inline void flush(const Tp* first, const Tp* last, Flush mode = Flush::Sync)
+        { this->_obj->flush(first, last, mode); }
+    /** Writes every element back to the backing file. */
+    inline void flush(Flush mode = Flush::Sync)
+        { this->flush(this->begin(), this->end(), mode); }
 
-        switch (errno) {
-            case EACCES:
-                msg.append(": permission denied");
-            break;
-            case EINVAL:
-                msg.append(": invalid name");
-            break;
-            case EMFILE:
-            case ENFILE:
-                msg.append(": too many files open");
-            break;
-            case ENAMETOOLONG:
-                msg.append(": filename too long");
-            break;
-            default:
-                msg.append(": error code " + std::to_string(errno));
-            break;
-        }
+    /** @returns A file descriptor that can be passed to other processes
+     * with @ref sendDescriptor, or -1 if the backend does not keep one. */
+    inline int descriptor() const noexcept
+        { return this->_obj->descriptor(); }
 
-        throw FileError(msg);
-    }
+    /** @returns The time the constructor spent prefaulting and locking the
+     * mapping. */
+    inline std::chrono::nanoseconds prefault_time() const noexcept
+        { return this->_obj->prefault_time(); }
 
-    const auto err {ftruncate(this->fd, Sz)};
+    /** Direct access to the mapped memory. */
+    inline Tp* data() noexcept
+        { return this->get_typed(); }
+    inline const Tp* data() const noexcept
+        { return this->get_typed(); }
 
-    if (err == -1) {
-        // error handling
-        std::string msg {
-            "Shared memory: could not create shared memory object " + this->_name +
-            " of size " + std::to_string(Sz) + " bytes"
+    /** @returns An iterator to the beginning. */
+    inline Tp* begin()
+        { return this->data(); }
+    inline const Tp* begin() const
+        { return this->data(); }
+    inline const Tp* cbegin() const
+        { return this->data(); }
+
+    /** @returns An iterator to the end. */
+    inline Tp* end()
+        { return this->data() + this->size(); }
+    inline const Tp* end() const
+        { return this->data() + this->size(); }
+    inline const Tp* cend() const
+        { return this->data() + this->size(); }
+
+    /** Change notification.
+     * A writer calls @ref notify after modifying the array; readers block in
+     * @ref wait_for_change instead of polling it. Re-check the array before
+     * each wait: a change made after this handle was constructed, or after
+     * its last wait returned, ends the next wait immediately.
+     * @note @ref notify requires write permissions. */
+    inline void notify() noexcept
+        { this->_obj->header().notify(); }
+    /** Blocks until @ref notify is called on any handle to this SMO.
+     * @param spins The number of times to poll before sleeping; non-zero
+     * values trade CPU time for lower wake-up latency. */
+    inline void wait_for_change(unsigned spins = 0) noexcept
+        { this->_obj->header().wait(this->_seen, spins, nullptr); }
+    /** As above, but gives up after @a timeout.
+     * @returns `false` if the wait timed out. */
+    template<class Rep, class Period>
+    inline bool wait_for_change(
+        const std::chrono::duration<Rep, Period>& timeout, unsigned spins = 0) noexcept
+    {
+        const std::chrono::nanoseconds t {
+            std::chrono::duration_cast<std::chrono::nanoseconds>(timeout)
+        };
+        return this->_obj->header().wait(this->_seen, spins, &t);
+    }
+
+private:
+    /** @returns @a n, after checking that it is non-zero. */
+    static size_t checked_count(size_t n)
+    {
+        if (n == 0)
+            throw std::invalid_argument("Shared memory: cannot create array with size 0");
+        return n;
+    }
+
+    inline Tp* get_typed()
+        { return static_cast<Tp*>(this->_obj->get()); }
+    inline const Tp* get_typed() const
+        { return static_cast<const Tp*>(this->_obj->get()); }
+
+    std::shared_ptr<_SharedMemoryObject> _obj;
+
+    /** Number of elements. */
+    size_t _size;
+
+    /** Last change sequence observed by @ref wait_for_change. */
+    uint32_t _seen;
+};
+
+
+/** Lock-free single-producer, single-consumer ring buffer in a POSIX shared
+ * memory object (SMO).
+ * Exactly one process (or thread) may push and exactly one may pop. Neither
+ * side makes system calls or blocks once the SMO is mapped.
+ * The producer and consumer cursors live on separate cache lines, and each
+ * side keeps a cached copy of the other's cursor so that, in the steady state,
+ * the remote cache line is only read when the ring appears full or empty.
+ * @param Tp The element type. Must be trivially copyable.
+ * @param N The capacity of the ring. Must be a power of two.
+ */
+template<class Tp, size_t N>
+class SpscRing {
+public:
+    static_assert(N > 0 && (N & (N - 1)) == 0,
+        "SpscRing capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<Tp>::value,
+        "SpscRing element type must be trivially copyable");
+
+    /** Constructor.
+     * Opens the SMO, creating it if it does not already exist.
+     * A newly created (zero-filled) SMO is a valid, empty ring.
+     * @param name The name/identifier of the POSIX shared memory object.
+     * @note It is advised to use @ref formatName on the name used. */
+    SpscRing(const std::string& name, const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(name, sizeof(_Layout), Permissions::ReadWrite, opts,
+        _layout_of<_Layout>())}
+    {}
+
+    ~SpscRing() = default;
+
+    /** Handles are move-only. A moved-from handle must not be used. */
+    SpscRing(SpscRing&&) = default;
+    SpscRing& operator=(SpscRing&&) = default;
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /** Pushes a copy of @a value onto the ring. Producer side only.
+     * @returns `false` if the ring is full. */
+    inline bool try_push(const Tp& value) noexcept;
+
+    /** Pops the oldest element into @a value. Consumer side only.
+     * @returns `false` if the ring is empty. */
+    inline bool try_pop(Tp& value) noexcept;
+
+    /** @returns A pointer to the oldest element, or `nullptr` if the ring is
+     * empty. Consumer side only. The element stays valid until @ref pop. */
+    inline const Tp* front() noexcept;
+
+    /** Discards the oldest element. Consumer side only.
+     * Must only be called after @ref front returned a non-null pointer. */
+    inline void pop() noexcept;
+
+    /** @returns The number of elements in the ring.
+     * @note The value may be stale by the time it is used. */
+    inline size_t size() const noexcept
+    {
+        const auto& l {this->layout()};
+        return l.write_idx.load(std::memory_order_acquire)
+            - l.read_idx.load(std::memory_order_acquire);
+    }
+
+    /** @returns `true` if the ring is empty. */
+    inline bool empty() const noexcept
+        { return this->size() == 0; }
+
+    /** @returns @ref N; the maximum number of elements in the ring. */
+    constexpr size_t capacity() const noexcept
+        { return N; }
+
+private:
+    static constexpr size_t mask {N - 1};
+
+    /** Layout of the SMO.
+     * Cursors are free-running and masked on access. */
+    struct _Layout {
+        /** Producer's line: the write cursor and its cache of the reader's. */
+        alignas(_cache_line_size) std::atomic<size_t> write_idx;
+        size_t read_idx_cache;
+        /** Consumer's line: the read cursor and its cache of the writer's. */
+        alignas(_cache_line_size) std::atomic<size_t> read_idx;
+        size_t write_idx_cache;
+        /** Element storage. */
+        alignas(_cache_line_size) Tp slots[N];
+    };
+
+    inline _Layout& layout() noexcept
+        { return *static_cast<_Layout*>(this->_obj->get()); }
+    inline const _Layout& layout() const noexcept
+        { return *static_cast<const _Layout*>(this->_obj->get()); }
+
+    std::shared_ptr<_SharedMemoryObject> _obj;
+};
+
+
+/** Bounded lock-free multi-producer, multi-consumer queue in a POSIX shared
+ * memory object (SMO).
+ * Any number of processes (or threads) may push and pop concurrently. Each
+ * slot carries a sequence number that tells producers and consumers whether
+ * it is free or full for their ticket, so claiming a slot is a single CAS on
+ * the shared enqueue or dequeue cursor (after D. Vyukov's bounded MPMC queue).
+ * @param Tp The element type. Must be trivially copyable.
+ * @param N The capacity of the queue. Must be a power of two.
+ */
+template<class Tp, size_t N>
+class MpmcQueue {
+public:
+    static_assert(N > 0 && (N & (N - 1)) == 0,
+        "MpmcQueue capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<Tp>::value,
+        "MpmcQueue element type must be trivially copyable");
+
+    /** Constructor.
+     * Opens the SMO, creating it if it does not already exist.
+     * A newly created (zero-filled) SMO is a valid, empty queue.
+     * @param name The name/identifier of the POSIX shared memory object.
+     * @note It is advised to use @ref formatName on the name used. */
+    MpmcQueue(const std::string& name, const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(name, sizeof(_Layout), Permissions::ReadWrite, opts,
+        _layout_of<_Layout>())}
+    {}
+
+    ~MpmcQueue() = default;
+
+    /** Handles are move-only. A moved-from handle must not be used. */
+    MpmcQueue(MpmcQueue&&) = default;
+    MpmcQueue& operator=(MpmcQueue&&) = default;
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    /** Pushes a copy of @a value onto the queue.
+     * @returns `false` if the queue is full. */
+    inline bool try_push(const Tp& value) noexcept;
+
+    /** Pops the oldest element into @a value.
+     * @returns `false` if the queue is empty. */
+    inline bool try_pop(Tp& value) noexcept;
+
+    /** @returns The approximate number of elements in the queue. */
+    inline size_t size() const noexcept
+    {
+        const auto& l {this->layout()};
+        const auto w {l.enqueue_pos.load(std::memory_order_acquire)};
+        const auto r {l.dequeue_pos.load(std::memory_order_acquire)};
+        return w > r ? w - r : 0;
+    }
+
+    /** @returns `true` if the queue is (approximately) empty. */
+    inline bool empty() const noexcept
+        { return this->size() == 0; }
+
+    /** @returns @ref N; the maximum number of elements in the queue. */
+    constexpr size_t capacity() const noexcept
+        { return N; }
+
+private:
+    static constexpr size_t mask {N - 1};
+
+    /** A queue slot.
+     * @ref seq is stored relative to the slot's index so that a zero-filled
+     * slot reads as "free for the first lap". */
+    struct _Slot {
+        std::atomic<size_t> seq;
+        Tp value;
+    };
+
+    /** Layout of the SMO. */
+    struct _Layout {
+        alignas(_cache_line_size) std::atomic<size_t> enqueue_pos;
+        alignas(_cache_line_size) std::atomic<size_t> dequeue_pos;
+        alignas(_cache_line_size) _Slot slots[N];
+    };
+
+    inline _Layout& layout() noexcept
+        { return *static_cast<_Layout*>(this->_obj->get()); }
+    inline const _Layout& layout() const noexcept
+        { return *static_cast<const _Layout*>(this->_obj->get()); }
+
+    std::shared_ptr<_SharedMemoryObject> _obj;
+};
+
+
+/** Class for sharing a snapshot of an object through a POSIX shared memory
+ * object (SMO), protected by a sequence lock.
+ * Unlike @ref Object, readers never observe a partially written value: they
+ * take a copy and retry if a write overlapped it. Readers never block
+ * writers, and need only read permissions. Concurrent writers are serialised
+ * against each other.
+ * @param Tp The object type. Must be trivially copyable.
+ */
+template<class Tp>
+class SeqObject {
+public:
+    static_assert(std::is_trivially_copyable<Tp>::value,
+        "SeqObject type must be trivially copyable");
+
+    /** Constructor.
+     * Opens the SMO, creating it if it does not already exist.
+     * @param name The name/identifier of the POSIX shared memory object.
+     * @note It is advised to use @ref formatName on the name used. */
+    SeqObject(const std::string& name, Permissions perm = Permissions::ReadWrite,
+        const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(name, sizeof(_Layout), perm, opts, _layout_of<_Layout>())}
+    {}
+
+    ~SeqObject() = default;
+
+    /** Handles are move-only. A moved-from handle must not be used. */
+    SeqObject(SeqObject&&) = default;
+    SeqObject& operator=(SeqObject&&) = default;
+    SeqObject(const SeqObject&) = delete;
+    SeqObject& operator=(const SeqObject&) = delete;
+
+    /** Publishes a copy of @a value to all readers.
+     * Requires write permissions. */
+    inline void store(const Tp& value) noexcept;
+
+    /** @returns A consistent copy of the most recently stored value.
+     * Retries while a write is in progress. */
+    inline Tp load() const noexcept;
+
+    /** Attempts to take a consistent copy of the value without retrying.
+     * @returns `false` if a write overlapped the copy, in which case
+     * @a value is unspecified. */
+    inline bool try_load(Tp& value) const noexcept;
+
+    /** @returns The number of completed stores. */
+    inline uint64_t version() const noexcept
+        { return this->layout().seq.load(std::memory_order_acquire) / 2; }
+
+private:
+    /** Layout of the SMO.
+     * @ref seq is odd while a write is in progress. */
+    struct _Layout {
+        alignas(_cache_line_size) std::atomic<uint64_t> seq;
+        alignas(_cache_line_size) Tp value;
+    };
+
+    inline _Layout& layout() noexcept
+        { return *static_cast<_Layout*>(this->_obj->get()); }
+    inline const _Layout& layout() const noexcept
+        { return *static_cast<const _Layout*>(this->_obj->get()); }
+
+    std::shared_ptr<_SharedMemoryObject> _obj;
+};
+
+
+/** Class for sharing the latest value of an object through a POSIX shared
+ * memory object (SMO), using triple buffering.
+ * The SMO holds three copies of the object. The writer fills one copy in
+ * place and publishes it with a single atomic exchange; the reader swaps to
+ * the most recently published copy the same way. Neither side ever waits for
+ * the other, however large the object.
+ * There must be at most one writer and one reader at a time. Both need write
+ * permissions to the SMO.
+ * @param Tp The object type.
+ */
+template<class Tp>
+class LatestValue {
+public:
+    /** Constructor.
+     * Opens the SMO, creating it if it does not already exist.
+     * @param name The name/identifier of the POSIX shared memory object.
+     * @note It is advised to use @ref formatName on the name used. */
+    LatestValue(const std::string& name, const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(name, sizeof(_Layout), Permissions::ReadWrite, opts,
+        _layout_of<_Layout>())}
+    {}
+
+    ~LatestValue() = default;
+
+    /** Handles are move-only. A moved-from handle must not be used. */
+    LatestValue(LatestValue&&) = default;
+    LatestValue& operator=(LatestValue&&) = default;
+    LatestValue(const LatestValue&) = delete;
+    LatestValue& operator=(const LatestValue&) = delete;
+
+    /** Reader access.
+     * Each access first switches to the most recently published value, if
+     * there is a newer one. The returned reference stays valid and unchanged
+     * until the next reader access; take a reference through @ref get to
+     * read several fields of the same value. */
+    inline operator const Tp&() noexcept
+        { return this->get(); }
+    inline const Tp* operator->() noexcept
+        { return &this->get(); }
+    inline const Tp& get() noexcept
+        { this->update(); return this->front(); }
+
+    /** @returns `true` if a value newer than the one last read has been
+     * published. */
+    inline bool has_update() const noexcept
+        { return this->layout().state.load(std::memory_order_acquire) & fresh_bit; }
+
+    /** Writer access.
+     * @returns The copy being written, which is not visible to the reader
+     * until @ref publish is called. */
+    inline Tp& back() noexcept
+        { return this->layout().buffers[this->layout().back_idx].value; }
+
+    /** Makes the copy returned by @ref back visible to the reader, and
+     * starts a new one. The new copy's contents are unspecified. */
+    inline void publish() noexcept;
+
+    /** Writes and publishes a copy of @a obj. */
+    inline LatestValue& operator=(const Tp& obj)
+        { this->back() = obj; this->publish(); return *this; }
+    inline LatestValue& operator=(Tp&& obj)
+        { this->back() = std::move(obj); this->publish(); return *this; }
+
+private:
+    /** State word flag: the middle copy has not been read yet. */
+    static constexpr uint32_t fresh_bit {4};
+    /** State word mask for the (encoded) index of the middle copy. */
+    static constexpr uint32_t index_mask {3};
+
+    /** Switches the reader to the middle copy if it is fresh. */
+    inline void update() noexcept;
+
+    inline const Tp& front() noexcept
+        { return this->layout().buffers[this->layout().front_idx ^ 2].value; }
+
+    struct _Buffer {
+        alignas(_cache_line_size) Tp value;
+    };
+
+    /** Layout of the SMO.
+     * Indices are encoded so that a zero-filled SMO starts with the writer,
+     * middle and reader on copies 0, 1 and 2 respectively: @ref state holds
+     * the middle index XOR 1, and @ref front_idx the reader's index XOR 2. */
+    struct _Layout {
+        alignas(_cache_line_size) std::atomic<uint32_t> state;
+        /** Writer-owned. */
+        alignas(_cache_line_size) uint32_t back_idx;
+        /** Reader-owned. */
+        alignas(_cache_line_size) uint32_t front_idx;
+        _Buffer buffers[3];
+    };
+
+    inline _Layout& layout() noexcept
+        { return *static_cast<_Layout*>(this->_obj->get()); }
+    inline const _Layout& layout() const noexcept
+        { return *static_cast<const _Layout*>(this->_obj->get()); }
+
+    std::shared_ptr<_SharedMemoryObject> _obj;
+};
+
+
+/** Reference to a chunk of a @ref ChunkPool, released on destruction.
+ * Keeps the pool's mapping alive. */
+class _ChunkRef {
+public:
+    ~_ChunkRef()
+        { this->release(); }
+
+    /** References are move-only. */
+    _ChunkRef(_ChunkRef&& other) noexcept:
+    _obj{std::move(other._obj)},
+    _refs{other._refs},
+    _data{other._data},
+    _offset{other._offset},
+    _size{other._size}
+    {
+        other._refs = nullptr;
+    }
+    _ChunkRef& operator=(_ChunkRef&& other) noexcept
+    {
+        if (this != &other) {
+            this->release();
+            this->_obj = std::move(other._obj);
+            this->_refs = other._refs;
+            this->_data = other._data;
+            this->_offset = other._offset;
+            this->_size = other._size;
+            other._refs = nullptr;
+        }
+        return *this;
+    }
+    _ChunkRef(const _ChunkRef&) = delete;
+    _ChunkRef& operator=(const _ChunkRef&) = delete;
+
+    /** @returns `true` if this refers to a chunk. */
+    explicit operator bool() const noexcept
+        { return this->_refs != nullptr; }
+
+    /** @returns The offset of the chunk within the pool's chunk storage;
+     * the descriptor subscribers receive. */
+    inline uint64_t offset() const noexcept
+        { return this->_offset; }
+
+    /** Drops the reference early. The chunk is reused once every reference
+     * to it is dropped. */
+    inline void release() noexcept
+    {
+        if (this->_refs != nullptr)
+            this->_refs->fetch_sub(1, std::memory_order_release);
+        this->_refs = nullptr;
+        this->_obj.reset();
+    }
+
+protected:
+    _ChunkRef() noexcept:
+    _refs{nullptr},
+    _data{nullptr},
+    _offset{0},
+    _size{0}
+    {}
+
+    _ChunkRef(std::shared_ptr<_SharedMemoryObject> obj, std::atomic<uint32_t>& refs,
+        unsigned char* data, uint64_t offset, size_t size) noexcept:
+    _obj{std::move(obj)},
+    _refs{&refs},
+    _data{data},
+    _offset{offset},
+    _size{size}
+    {}
+
+    std::shared_ptr<_SharedMemoryObject> _obj;
+
+    /** The chunk's reference count in the SMO, or `nullptr` if none. */
+    std::atomic<uint32_t>* _refs;
+
+    unsigned char* _data;
+    uint64_t _offset;
+    size_t _size;
+};
+
+
+/** A chunk loaned from a @ref ChunkPool to be filled in place and published.
+ * Returned to the pool if destroyed without being published. */
+class ChunkLoan : public _ChunkRef {
+public:
+    ChunkLoan() noexcept = default;
+
+    /** @returns The chunk's memory, to be written in place. */
+    inline unsigned char* data() noexcept
+        { return this->_data; }
+
+    /** @returns The number of bytes in the chunk. */
+    inline size_t capacity() const noexcept
+        { return this->_size; }
+
+private:
+    template<size_t, size_t, size_t> friend class ChunkPool;
+
+    ChunkLoan(std::shared_ptr<_SharedMemoryObject> obj, std::atomic<uint32_t>& refs,
+        unsigned char* data, uint64_t offset, size_t size) noexcept:
+    _ChunkRef(std::move(obj), refs, data, offset, size)
+    {}
+};
+
+
+/** A read-only view of a chunk published to a @ref ChunkPool.
+ * The chunk cannot be reused until the view is destroyed or released. */
+class ChunkView : public _ChunkRef {
+public:
+    ChunkView() noexcept = default;
+
+    /** @returns The published data. */
+    inline const unsigned char* data() const noexcept
+        { return this->_data; }
+
+    /** @returns The number of bytes published. */
+    inline size_t size() const noexcept
+        { return this->_size; }
+
+private:
+    template<size_t, size_t, size_t> friend class ChunkPool;
+
+    ChunkView(std::shared_ptr<_SharedMemoryObject> obj, std::atomic<uint32_t>& refs,
+        unsigned char* data, uint64_t offset, size_t size) noexcept:
+    _ChunkRef(std::move(obj), refs, data, offset, size)
+    {}
+};
+
+
+/** Class for zero-copy publishing of large messages, e.g. camera frames, to
+ * any number of subscribers.
+ * The publisher loans a chunk, writes the message in place and publishes it;
+ * subscribers receive read-only views of the same memory. Each chunk has a
+ * reference count in the SMO, so it is only loaned again once the publisher
+ * and every subscriber viewing it are done with it. The data is never copied.
+ * Published messages are kept in a ring of @ref Depth descriptors: a
+ * subscriber that falls further behind skips the oldest messages.
+ * @tparam ChunkSize The maximum size of a message, in bytes.
+ * @tparam Chunks The number of chunks.
+ * @tparam Depth The number of published messages kept for subscribers.
+ * Must be less than @ref Chunks, leaving chunks for the publisher to loan.
+ * @note Only one process may publish at a time.
+ * @note A process that dies holding a loan or view leaks its chunk. */
+template<size_t ChunkSize, size_t Chunks, size_t Depth = Chunks / 2>
+class ChunkPool {
+public:
+    static_assert(ChunkSize > 0, "Cannot create chunk pool with chunk size 0");
+    static_assert(Depth > 0 && Depth < Chunks,
+        "ChunkPool depth must be non-zero and less than the number of chunks");
+
+    /** Constructor.
+     * Opens the SMO, creating it if it does not already exist.
+     * A newly created (zero-filled) SMO is a valid pool with every chunk free.
+     * The handle receives messages published after it was constructed.
+     * @param name The name/identifier of the POSIX shared memory object.
+     * @note It is advised to use @ref formatName on the name used. */
+    ChunkPool(const std::string& name, const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(name, sizeof(_Layout), Permissions::ReadWrite, opts,
+        _layout_of<_Layout>())},
+    _cursor{layout().published.load(std::memory_order_acquire)},
+    _next{0},
+    _missed{0}
+    {}
+
+    ~ChunkPool() = default;
+
+    /** Handles are move-only. A moved-from handle must not be used. */
+    ChunkPool(ChunkPool&&) = default;
+    ChunkPool& operator=(ChunkPool&&) = default;
+    ChunkPool(const ChunkPool&) = delete;
+    ChunkPool& operator=(const ChunkPool&) = delete;
+
+    /** Loans a free chunk into @a loan. Publisher side.
+     * @returns `false` if every chunk is in use. */
+    inline bool try_loan(ChunkLoan& loan) noexcept;
+
+    /** Publishes the first @a length bytes of a loaned chunk to subscribers,
+     * handing over the loan. Publisher side.
+     * @throws std::invalid_argument if @a loan is empty or was loaned by
+     * another pool.
+     * @throws std::length_error if @a length exceeds the chunk size. */
+    inline void publish(ChunkLoan&& loan, size_t length);
+
+    /** Receives a view of the next published message into @a view.
+     * Subscriber side; each handle is a separate subscriber.
+     * @returns `false` if there is no new message. */
+    inline bool try_receive(ChunkView& view) noexcept;
+
+    /** @returns The number of messages this subscriber skipped because it
+     * fell too far behind. */
+    inline uint64_t missed() const noexcept
+        { return this->_missed; }
+
+    /** @returns @ref ChunkSize; the maximum size of a message. */
+    constexpr size_t chunk_size() const noexcept
+        { return ChunkSize; }
+
+private:
+    /** Distance between chunks, keeping each cache line aligned. */
+    static constexpr size_t stride {
+        (ChunkSize + _cache_line_size - 1) / _cache_line_size * _cache_line_size
+    };
+
+    /** A published message. Rewritten seqlock-style: @ref seq is zero while
+     * the other fields change. */
+    struct _Slot {
+        /** One more than the message's sequence number, or zero. */
+        std::atomic<uint64_t> seq;
+        std::atomic<uint64_t> offset;
+        std::atomic<uint64_t> length;
+    };
+
+    /** Layout of the SMO. */
+    struct _Layout {
+        /** The number of messages published. */
+        alignas(_cache_line_size) std::atomic<uint64_t> published;
+        /** Descriptors of the last @ref Depth messages. */
+        alignas(_cache_line_size) _Slot slots[Depth];
+        /** Reference counts: zero for a free chunk. The slot holding a
+         * message's descriptor counts as one reference. */
+        alignas(_cache_line_size) std::atomic<uint32_t> refs[Chunks];
+        /** Chunk storage. */
+        alignas(_cache_line_size) unsigned char chunks[Chunks][stride];
+    };
+
+    inline _Layout& layout() noexcept
+        { return *static_cast<_Layout*>(this->_obj->get()); }
+
+    std::shared_ptr<_SharedMemoryObject> _obj;
+
+    /** Sequence number of the next message to receive. */
+    uint64_t _cursor;
+
+    /** Chunk to try to loan first. */
+    size_t _next;
+
+    /** Messages skipped by this subscriber. */
+    uint64_t _missed;
+};
+
+
+/** Class for a lock-free single-producer, single-consumer ring of
+ * variable-length messages in shared memory.
+ * Each message is stored as a record: an 8-byte header holding its length,
+ * then the message, padded to a multiple of 8 bytes. A message never wraps
+ * around the end of the ring; a padding record fills the gap instead.
+ * Messages are written and read in place, without copying.
+ * @tparam N The capacity in bytes. Must be a power of two, at least 64. */
+template<size_t N>
+class MessageRing {
+public:
+    static_assert(N >= 64 && (N & (N - 1)) == 0,
+        "MessageRing capacity must be a power of two, at least 64 bytes");
+
+    /** Constructor.
+     * Opens the SMO, creating it if it does not already exist.
+     * A newly created (zero-filled) SMO is a valid, empty ring.
+     * @param name The name/identifier of the POSIX shared memory object.
+     * @note It is advised to use @ref formatName on the name used. */
+    MessageRing(const std::string& name, const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(name, sizeof(_Layout), Permissions::ReadWrite, opts,
+        _layout_of<_Layout>())},
+    _reserved{0},
+    _peeked{0}
+    {}
+
+    ~MessageRing() = default;
+
+    /** Handles are move-only. A moved-from handle must not be used. */
+    MessageRing(MessageRing&&) = default;
+    MessageRing& operator=(MessageRing&&) = default;
+    MessageRing(const MessageRing&) = delete;
+    MessageRing& operator=(const MessageRing&) = delete;
+
+    /** Reserves space for a message of @a length bytes. Producer side only.
+     * The message is written in place, then published with @ref commit.
+     * @returns A pointer to the (8-byte aligned) space, or `nullptr` if the
+     * ring is too full.
+     * @throws std::length_error if @a length exceeds @ref max_message. */
+    inline unsigned char* try_reserve(size_t length);
+
+    /** Publishes the message written after @ref try_reserve.
+     * Producer side only. */
+    inline void commit() noexcept
+        { this->commit(this->_reserved); }
+
+    /** As above, but publishes only the first @a length bytes, which must be
+     * at most the length reserved. */
+    inline void commit(size_t length) noexcept;
+
+    /** @returns A pointer to the oldest message, or `nullptr` if the ring is
+     * empty, and writes its length to @a length. Consumer side only.
+     * The message stays valid until @ref consume. */
+    inline const unsigned char* peek(size_t& length) noexcept;
+
+    /** Discards the oldest message. Consumer side only.
+     * Must only be called after @ref peek returned a non-null pointer. */
+    inline void consume() noexcept;
+
+    /** @returns `true` if the ring is empty.
+     * @note The value may be stale by the time it is used. */
+    inline bool empty() const noexcept
+    {
+        const auto& l {this->layout()};
+        return l.write_idx.load(std::memory_order_acquire)
+            == l.read_idx.load(std::memory_order_acquire);
+    }
+
+    /** @returns @ref N; the capacity in bytes. */
+    constexpr size_t capacity() const noexcept
+        { return N; }
+
+    /** @returns The largest message that can be sent. */
+    constexpr size_t max_message() const noexcept
+        { return N / 2 - sizeof(_Record); }
+
+private:
+    static constexpr size_t mask {N - 1};
+
+    /** Header of every record. */
+    struct _Record {
+        /** Length of the message, excluding this header and padding. */
+        uint32_t length;
+        /** Non-zero for a padding record, which holds no message. */
+        uint32_t padding;
+    };
+
+    /** @returns The size of the record holding a message of @a length bytes. */
+    static constexpr size_t record_size(size_t length) noexcept
+        { return (sizeof(_Record) + length + 7) & ~size_t(7); }
+
+    /** Layout of the SMO.
+     * Cursors count bytes, are free-running and masked on access. */
+    struct _Layout {
+        /** Producer's line: the write cursor and its cache of the reader's. */
+        alignas(_cache_line_size) std::atomic<size_t> write_idx;
+        size_t read_idx_cache;
+        /** Consumer's line: the read cursor and its cache of the writer's. */
+        alignas(_cache_line_size) std::atomic<size_t> read_idx;
+        size_t write_idx_cache;
+        /** Record storage. */
+        alignas(_cache_line_size) unsigned char bytes[N];
+    };
+
+    inline _Layout& layout() noexcept
+        { return *static_cast<_Layout*>(this->_obj->get()); }
+    inline const _Layout& layout() const noexcept
+        { return *static_cast<const _Layout*>(this->_obj->get()); }
+
+    std::shared_ptr<_SharedMemoryObject> _obj;
+
+    /** Length of the message reserved by the producer. */
+    size_t _reserved;
+
+    /** Size of the record returned by the last @ref peek, or zero. */
+    size_t _peeked;
+};
+
+
+/** Class for a shared memory array that is mapped twice, back to back, so
+ * element `i + Sz` is element `i`. Any run of up to @ref Sz elements is then
+ * contiguous, even across the end of the array: rings and parsers can copy
+ * or scan it in one go instead of splitting at the wrap-around.
+ * Every handle to the SMO must be a `MirroredArray` (see
+ * @ref Options::mirror).
+ * @note `sizeof(Tp) * Sz` must be a multiple of the page size. */
+template<class Tp, size_t Sz>
+class MirroredArray {
+public:
+    static_assert(Sz > 0, "Cannot create shared memory array with size 0");
+
+    /** Constructor.
+     * Opens the SMO, creating it if it does not already exist.
+     * @param name The name/identifier of the POSIX shared memory object.
+     * @note It is advised to use @ref formatName on the name used.
+     * @throws MemoryError if the array is not a multiple of the page size. */
+    MirroredArray(const std::string& name, Permissions perm = Permissions::ReadWrite,
+        const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(name, sizeof(Tp) * Sz, perm, mirrored(opts),
+        _fnv_mix(_layout_of<Tp>(Sz), 1))}
+    {}
+
+    /** Constructor.
+     * Maps the shared memory referred to by @a fd, e.g. one received with
+     * @ref receiveDescriptor. The caller keeps ownership of @a fd. */
+    MirroredArray(int fd, Permissions perm = Permissions::ReadWrite,
+        const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(fd, sizeof(Tp) * Sz, perm, mirrored(opts),
+        _fnv_mix(_layout_of<Tp>(Sz), 1))}
+    {}
+
+    ~MirroredArray() = default;
+
+    /** Handles are move-only. A moved-from handle must not be used. */
+    MirroredArray(MirroredArray&&) = default;
+    MirroredArray& operator=(MirroredArray&&) = default;
+    MirroredArray(const MirroredArray&) = delete;
+    MirroredArray& operator=(const MirroredArray&) = delete;
+
+    /** Element access, for @a n less than twice @ref Sz. */
+    inline Tp& operator[](size_t n) noexcept
+        { return this->get_typed()[n]; }
+    inline const Tp& operator[](size_t n) const noexcept
+        { return this->get_typed()[n]; }
+
+    /** @returns A pointer to element @a start (modulo @ref Sz), followed by
+     * at least @ref Sz contiguous elements. */
+    inline Tp* window(size_t start) noexcept
+        { return this->get_typed() + start % Sz; }
+    inline const Tp* window(size_t start) const noexcept
+        { return this->get_typed() + start % Sz; }
+
+    /** @returns The number of @ref Tp objects in the array (not counting
+     * the mirror). */
+    constexpr size_t size() const noexcept
+        { return Sz; }
+
+    /** Direct access to the mapped memory; `2 * Sz` elements long. */
+    inline Tp* data() noexcept
+        { return this->get_typed(); }
+    inline const Tp* data() const noexcept
+        { return this->get_typed(); }
+
+    /** @returns A file descriptor that can be passed to other processes
+     * with @ref sendDescriptor, or -1 if the backend does not keep one. */
+    inline int descriptor() const noexcept
+        { return this->_obj->descriptor(); }
+
+private:
+    static Options mirrored(Options opts)
+        { opts.mirror = true; return opts; }
+
+    inline Tp* get_typed()
+        { return static_cast<Tp*>(this->_obj->get()); }
+    inline const Tp* get_typed() const
+        { return static_cast<const Tp*>(this->_obj->get()); }
+
+    std::shared_ptr<_SharedMemoryObject> _obj;
+};
+
+
+/** Pointer that stays valid when the memory holding it is mapped at
+ * different addresses in different processes: it stores the distance from
+ * itself to its target, rather than the target's address. Use it for
+ * pointers stored in shared memory to elsewhere in the same SMO.
+ * A zero-filled `offset_ptr` is null.
+ * @note Copying an `offset_ptr` recomputes the distance, so it can be
+ * copied in and out of shared memory freely. It cannot point to itself. */
+template<class T>
+class offset_ptr {
+public:
+    using element_type = T;
+    using value_type = typename std::remove_cv<T>::type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = typename std::add_lvalue_reference<T>::type;
+    using iterator_category = std::random_access_iterator_tag;
+
+    offset_ptr() noexcept: _offset{0} {}
+    offset_ptr(std::nullptr_t) noexcept: _offset{0} {}
+    offset_ptr(T* p) noexcept: _offset{this->encode(p)} {}
+    offset_ptr(const offset_ptr& other) noexcept: _offset{this->encode(other.get())} {}
+
+    /** Implicit conversion, as for raw pointers. */
+    template<class U>
+    offset_ptr(const offset_ptr<U>& other,
+        typename std::enable_if<std::is_convertible<U*, T*>::value, int>::type = 0) noexcept:
+    _offset{this->encode(other.get())}
+    {}
+
+    /** Explicit conversion, as `static_cast` for raw pointers. */
+    template<class U>
+    explicit offset_ptr(const offset_ptr<U>& other,
+        typename std::enable_if<!std::is_convertible<U*, T*>::value, int>::type = 0) noexcept:
+    _offset{this->encode(static_cast<T*>(other.get()))}
+    {}
+
+    inline offset_ptr& operator=(const offset_ptr& other) noexcept
+        { this->_offset = this->encode(other.get()); return *this; }
+    inline offset_ptr& operator=(T* p) noexcept
+        { this->_offset = this->encode(p); return *this; }
+
+    /** @returns The raw pointer, valid in this process. */
+    inline T* get() const noexcept
+    {
+        return this->_offset == 0
+            ? nullptr
+            : reinterpret_cast<T*>(reinterpret_cast<std::intptr_t>(this) + this->_offset);
+    }
+
+    inline reference operator*() const noexcept
+        { return *this->get(); }
+    inline T* operator->() const noexcept
+        { return this->get(); }
+    inline reference operator[](difference_type n) const noexcept
+        { return this->get()[n]; }
+
+    /** Converts to the raw pointer, as some standard containers (e.g.
+     * libstdc++'s `std::basic_string`) expect of allocator pointers. Also
+     * provides comparisons, with raw pointers and `nullptr` too. */
+    operator T*() const noexcept
+        { return this->get(); }
+
+    /** For `std::pointer_traits`. */
+    template<class R = T>
+    static offset_ptr pointer_to(
+        typename std::enable_if<!std::is_void<R>::value, R>::type& r) noexcept
+        { return offset_ptr(std::addressof(r)); }
+
+    inline offset_ptr& operator++() noexcept
+        { return *this = this->get() + 1; }
+    inline offset_ptr& operator--() noexcept
+        { return *this = this->get() - 1; }
+    inline offset_ptr operator++(int) noexcept
+        { offset_ptr old {*this}; ++*this; return old; }
+    inline offset_ptr operator--(int) noexcept
+        { offset_ptr old {*this}; --*this; return old; }
+    inline offset_ptr& operator+=(difference_type n) noexcept
+        { return *this = this->get() + n; }
+    inline offset_ptr& operator-=(difference_type n) noexcept
+        { return *this = this->get() - n; }
+
+    friend offset_ptr operator+(const offset_ptr& p, difference_type n) noexcept
+        { return p.get() + n; }
+    friend offset_ptr operator+(difference_type n, const offset_ptr& p) noexcept
+        { return p.get() + n; }
+    friend offset_ptr operator-(const offset_ptr& p, difference_type n) noexcept
+        { return p.get() - n; }
+    friend difference_type operator-(const offset_ptr& a, const offset_ptr& b) noexcept
+        { return a.get() - b.get(); }
+
+private:
+    inline std::ptrdiff_t encode(const volatile void* p) const noexcept
+    {
+        return p == nullptr
+            ? 0
+            : reinterpret_cast<std::intptr_t>(p) - reinterpret_cast<std::intptr_t>(this);
+    }
+
+    /** Distance from this object to the target, or zero for null. */
+    std::ptrdiff_t _offset;
+};
+
+
+/** Lock word shared between processes, sleeping on a futex when contended.
+ * A zero-filled lock is unlocked.
+ * @note Not robust: a process that dies holding it leaves it locked. */
+struct _FutexLock {
+    /** 0: unlocked, 1: locked, 2: locked with (possible) waiters. */
+    std::atomic<uint32_t> state;
+
+    inline void lock() noexcept;
+    inline void unlock() noexcept;
+};
+
+
+/** Bookkeeping of a @ref Heap, at the start of its SMO.
+ * A two-level segregated fit (TLSF) allocator: free blocks are kept in
+ * lists by size class, found through two levels of bitmaps, so allocating
+ * and freeing take constant time. Everything is stored as offsets from the
+ * start of this structure. */
+struct _HeapControl {
+    enum : size_t {
+        /** Allocations are aligned to, and a multiple of, this. */
+        align = 16,
+        align_log2 = 4,
+        /** Second-level lists per first-level class. */
+        sl_log2 = 4,
+        sl_count = 1 << sl_log2,
+        /** Sizes below `1 << fl_shift` all share the first class. */
+        fl_shift = sl_log2 + align_log2,
+        fl_count = 48,
+        /** Size of the header before every block's payload. */
+        block_overhead = 16,
+        /** Smallest payload: enough for the free list links. */
+        min_payload = 16
+    };
+
+    _FutexLock lock;
+
+    /** Size of the heap, including this structure. */
+    uint64_t capacity;
+
+    /** Bytes free for payloads. */
+    uint64_t free_bytes;
+
+    /** Bit `f` is set if any list in first-level class `f` is non-empty. */
+    uint64_t fl_bitmap;
+    /** Bit `s` of entry `f` is set if list `[f][s]` is non-empty. */
+    uint32_t sl_bitmap[fl_count];
+    /** Offsets of the first block of each free list, or zero. */
+    uint64_t heads[fl_count][sl_count];
+
+    /** Makes the whole of the @a bytes from this structure onwards one free
+     * block. */
+    inline void init(size_t bytes) noexcept;
+
+    /** @returns @a bytes of memory, aligned to @ref align, or `nullptr` if
+     * there is no free block big enough. */
+    inline void* allocate(size_t bytes) noexcept;
+
+    /** Frees memory returned by @ref allocate. */
+    inline void deallocate(void* p) noexcept;
+
+private:
+    /** Header of every block, followed by its payload. The free list links
+     * overlay the start of the payload of free blocks. */
+    struct _Block {
+        /** Offset of the previous block in memory; valid if that is free. */
+        uint64_t prev_phys;
+        /** Payload size, with @ref free_bit and @ref prev_free_bit. */
+        uint64_t size;
+        uint64_t next_free;
+        uint64_t prev_free;
+
+        enum : uint64_t { free_bit = 1, prev_free_bit = 2, flags = 3 };
+
+        inline uint64_t payload() const noexcept
+            { return this->size & ~uint64_t(flags); }
+        inline void set_payload(uint64_t n) noexcept
+            { this->size = n | (this->size & flags); }
+    };
+
+    inline _Block* block(uint64_t off) noexcept
+        { return reinterpret_cast<_Block*>(reinterpret_cast<char*>(this) + off); }
+
+    /** @returns The offset of the block after the one at @a off. */
+    inline uint64_t next_phys(uint64_t off) noexcept
+        { return off + block_overhead + this->block(off)->payload(); }
+
+    /** Finds the list holding free blocks with a payload of @a size. */
+    static inline void mapping(uint64_t size, unsigned& fl, unsigned& sl) noexcept;
+
+    /** Adds the free block at @a off to its list. */
+    inline void insert(uint64_t off) noexcept;
+
+    /** Removes the free block at @a off from its list. */
+    inline void remove(uint64_t off) noexcept;
+};
+
+
+/** Allocator for standard containers, allocating from a @ref Heap.
+ * Its pointers are @ref offset_ptr "offset_ptrs", so a container built in
+ * the heap (see @ref Heap::construct) can be used by every process that
+ * maps the heap, e.g.
+ * `std::vector<int, shm::Allocator<int>>` or
+ * `std::basic_string<char, std::char_traits<char>, shm::Allocator<char>>`. */
+template<class T>
+class Allocator {
+public:
+    static_assert(alignof(T) <= _HeapControl::align,
+        "Heap allocations are only 16-byte aligned");
+
+    using value_type = T;
+    using pointer = offset_ptr<T>;
+    using const_pointer = offset_ptr<const T>;
+    using void_pointer = offset_ptr<void>;
+    using const_void_pointer = offset_ptr<const void>;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    template<class U>
+    struct rebind {
+        using other = Allocator<U>;
+    };
+
+    template<class U>
+    Allocator(const Allocator<U>& other) noexcept:
+    _heap{other._heap}
+    {}
+
+    /** @throws std::bad_alloc if the heap is full. */
+    inline pointer allocate(size_t n)
+    {
+        if (n > SIZE_MAX / sizeof(T))
+            throw std::bad_alloc();
+
+        const auto p {this->_heap->allocate(n * sizeof(T))};
+        if (p == nullptr)
+            throw std::bad_alloc();
+        return pointer(static_cast<T*>(p));
+    }
+
+    inline void deallocate(pointer p, size_t) noexcept
+        { this->_heap->deallocate(p.get()); }
+
+    template<class U>
+    friend bool operator==(const Allocator& a, const Allocator<U>& b) noexcept
+        { return a._heap == b._heap; }
+    template<class U>
+    friend bool operator!=(const Allocator& a, const Allocator<U>& b) noexcept
+        { return a._heap != b._heap; }
+
+private:
+    template<class> friend class Allocator;
+    friend class Heap;
+    friend class Segment;
+
+    explicit Allocator(_HeapControl& heap) noexcept:
+    _heap{&heap}
+    {}
+
+    offset_ptr<_HeapControl> _heap;
+};
+
+
+/** Class for a general-purpose heap in a POSIX shared memory object (SMO),
+ * in which linked and variable-sized structures, including standard
+ * containers (see @ref Allocator), can be shared between processes.
+ * Pointers within the heap must be @ref offset_ptr "offset_ptrs"; pass
+ * locations between processes as offsets (@ref offset_of, @ref at).
+ * Allocating and freeing take constant time, under a lock in the SMO.
+ * @note A process that dies while allocating or freeing leaves the heap
+ * locked. */
+class Heap {
+public:
+    /** Constructor.
+     * Opens the SMO, creating it if it does not already exist, and sets up
+     * the heap if it is new.
+     * @param name The name/identifier of the POSIX shared memory object.
+     * @param bytes The size of the heap, including about 6 KiB of
+     * bookkeeping.
+     * @note It is advised to use @ref formatName on the name used.
+     * @throws std::invalid_argument if @a bytes is too small. */
+    inline Heap(const std::string& name, size_t bytes,
+        Permissions perm = Permissions::ReadWrite, const Options& opts = Options());
+
+    /** Constructor.
+     * Attaches to an existing heap, taking its size from the SMO. Read-only
+     * handles can read the heap, but not allocate from it.
+     * @param name The name/identifier of the POSIX shared memory object.
+     * @throws FileError if the SMO does not exist. */
+    inline Heap(const std::string& name, Permissions perm = Permissions::ReadWrite,
+        const Options& opts = Options());
+
+    ~Heap() = default;
+
+    /** Handles are move-only. A moved-from handle must not be used. */
+    Heap(Heap&&) = default;
+    Heap& operator=(Heap&&) = default;
+    Heap(const Heap&) = delete;
+    Heap& operator=(const Heap&) = delete;
+
+    /** @returns @a bytes of memory, 16-byte aligned.
+     * @throws std::bad_alloc if the heap is full.
+     * @throws FileError if the handle is read-only. */
+    inline void* allocate(size_t bytes);
+
+    /** Frees memory returned by @ref allocate. */
+    inline void deallocate(void* p) noexcept
+        { this->control().deallocate(p); }
+
+    /** Allocates and constructs a @a Tp from @a args in the heap. */
+    template<class Tp, class... Args>
+    Tp* construct(Args&&... args)
+    {
+        static_assert(alignof(Tp) <= _HeapControl::align,
+            "Heap allocations are only 16-byte aligned");
+
+        const auto p {this->allocate(sizeof(Tp))};
+        try {
+            return ::new (p) Tp(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            this->deallocate(p);
+            throw;
+        }
+    }
+
+    /** Destroys and frees an object made with @ref construct. */
+    template<class Tp>
+    void destroy(Tp* p) noexcept
+    {
+        if (p != nullptr) {
+            p->~Tp();
+            this->deallocate(p);
+        }
+    }
+
+    /** @returns An allocator for standard containers in this heap. */
+    template<class Tp>
+    Allocator<Tp> allocator() noexcept
+        { return Allocator<Tp>(this->control()); }
+
+    /** @returns The position of @a p in the heap, the same in every
+     * process. */
+    inline uint64_t offset_of(const void* p) const noexcept
+        { return static_cast<uint64_t>(static_cast<const char*>(p) - this->base()); }
+
+    /** @returns The object at @a offset in this process' mapping. */
+    template<class Tp>
+    Tp* at(uint64_t offset) noexcept
+        { return reinterpret_cast<Tp*>(const_cast<char*>(this->base()) + offset); }
+    template<class Tp>
+    const Tp* at(uint64_t offset) const noexcept
+        { return reinterpret_cast<const Tp*>(this->base() + offset); }
+
+    /** @returns `true` if @a p points into the heap. */
+    inline bool owns(const void* p) const noexcept
+    {
+        const auto c {static_cast<const char*>(p)};
+        return c >= this->base() && c < this->base() + this->capacity();
+    }
+
+    /** @returns The size of the heap, including bookkeeping. */
+    inline size_t capacity() const noexcept
+        { return this->_obj->size(); }
+
+    /** @returns The number of bytes free for allocations.
+     * @note The value may be stale by the time it is used. */
+    inline size_t free_bytes() const noexcept
+        { return reinterpret_cast<const volatile _HeapControl*>(this->base())->free_bytes; }
+
+private:
+    /** @returns @a bytes, if enough for the bookkeeping and one block.
+     * @throws std::invalid_argument otherwise. */
+    static inline size_t checked_size(size_t bytes);
+
+    /** Sets up the heap once, or waits for it to be set up. */
+    inline void init();
+
+    inline const char* base() const noexcept
+        { return static_cast<const char*>(this->_obj->get()); }
+    inline _HeapControl& control() noexcept
+        { return *static_cast<_HeapControl*>(this->_obj->get()); }
+
+    std::shared_ptr<_SharedMemoryObject> _obj;
+};
+
+
+/** Class for a pool of fixed-size objects in a POSIX shared memory object
+ * (SMO), shared between processes.
+ * Free slots are kept in a lock-free list whose head is tagged with a
+ * counter, so that a slot freed and reused while another process is
+ * popping it cannot corrupt the list (the ABA problem). Allocating and
+ * freeing never block, never make system calls and never fragment.
+ * Slots are identified by their index, which is the same in every process.
+ * Each handle can keep a local cache of free slots, taken from and returned
+ * to the shared list in batches, so that processes allocating and freeing
+ * often rarely contend on it.
+ * @tparam Tp The object type. Must be trivially copyable; slots are not
+ * constructed or destroyed.
+ * @tparam N The number of slots.
+ * @note A handle with a cache must not be used by several threads at once.
+ * @note A process that dies leaks the slots it had allocated or cached. */
+template<class Tp, size_t N>
+class Pool {
+public:
+    static_assert(N > 0 && N < UINT32_MAX, "Pool size must be non-zero and fit 32 bits");
+    static_assert(std::is_trivially_copyable<Tp>::value,
+        "Pool element type must be trivially copyable");
+
+    /** Constructor.
+     * Opens the SMO, creating it if it does not already exist.
+     * A newly created (zero-filled) SMO is a valid pool with every slot free.
+     * @param name The name/identifier of the POSIX shared memory object.
+     * @param cache The number of free slots this handle may keep locally,
+     * or 0 for none.
+     * @note It is advised to use @ref formatName on the name used. */
+    Pool(const std::string& name, size_t cache = 0, const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(name, sizeof(_Layout), Permissions::ReadWrite, opts,
+        _layout_of<_Layout>())},
+    _cache_size{cache}
+    {
+        this->_cache.reserve(cache);
+    }
+
+    /** Returns the cached slots to the shared list. */
+    ~Pool()
+        { this->drain(); }
+
+    /** Handles are move-only. A moved-from handle must not be used. */
+    Pool(Pool&&) = default;
+    Pool& operator=(Pool&& other) noexcept
+    {
+        this->drain();
+        this->_obj = std::move(other._obj);
+        this->_cache = std::move(other._cache);
+        this->_cache_size = other._cache_size;
+        other._cache.clear();
+        return *this;
+    }
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    /** Allocates a free slot.
+     * @param index Set to the index of the slot. Its contents are whatever
+     * was last stored in it (zeros for a new pool).
+     * @returns `false` if every slot is in use. */
+    inline bool try_allocate(uint32_t& index) noexcept;
+
+    /** Frees the slot at @a index, which must have been allocated by
+     * @ref try_allocate in any process. */
+    inline void deallocate(uint32_t index) noexcept;
+
+    /** Returns every slot in this handle's cache to the shared list. */
+    inline void drain() noexcept;
+
+    /** @returns The object in the slot at @a index. */
+    inline Tp& operator[](uint32_t index) noexcept
+        { return this->layout().values[index]; }
+    inline const Tp& operator[](uint32_t index) const noexcept
+        { return this->layout().values[index]; }
+
+    /** @returns The index of the slot holding @a obj. */
+    inline uint32_t index_of(const Tp* obj) const noexcept
+        { return static_cast<uint32_t>(obj - this->layout().values); }
+
+    /** @returns The number of free slots in this handle's cache. */
+    inline size_t cached() const noexcept
+        { return this->_cache.size(); }
+
+    /** @returns @ref N; the number of slots. */
+    constexpr size_t capacity() const noexcept
+        { return N; }
+
+private:
+    /** Index marking the end of the free list. */
+    static constexpr uint32_t end {static_cast<uint32_t>(N)};
+
+    /** Layout of the SMO.
+     * The free list head packs a tag (high half) with a slot index (low
+     * half), and every successful update increments the tag. Links are
+     * stored as `next ^ (index + 1)`, so that in a zero-filled SMO the list
+     * runs through every slot in order. */
+    struct _Layout {
+        alignas(_cache_line_size) std::atomic<uint64_t> head;
+        alignas(_cache_line_size) std::atomic<uint32_t> links[N];
+        alignas(_cache_line_size) Tp values[N];
+    };
+
+    /** Pops a slot off the shared list. */
+    inline bool pop(uint32_t& index) noexcept;
+
+    /** Pushes the chain of slots from @a first to @a last, already linked,
+     * onto the shared list. */
+    inline void push(uint32_t first, uint32_t last) noexcept;
+
+    inline void link(uint32_t index, uint32_t next) noexcept
+    {
+        this->layout().links[index].store(next ^ (index + 1), std::memory_order_relaxed);
+    }
+
+    inline _Layout& layout() noexcept
+        { return *static_cast<_Layout*>(this->_obj->get()); }
+    inline const _Layout& layout() const noexcept
+        { return *static_cast<const _Layout*>(this->_obj->get()); }
+
+    std::shared_ptr<_SharedMemoryObject> _obj;
+
+    /** Free slots held by this handle. */
+    std::vector<uint32_t> _cache;
+    size_t _cache_size;
+};
+
+
+/** Class for many named objects in one POSIX shared memory object (SMO).
+ * Objects are allocated from a @ref Heap in the SMO and found by name
+ * through a hash-indexed directory, so a process maps the SMO once instead
+ * of opening and mapping one SMO per object.
+ * Objects are constructed once, by whichever process asks for them first,
+ * and never destroyed. Lookups are lock-free and work with read-only
+ * handles; constructing takes a lock in the SMO.
+ * @note A process that dies while constructing leaves the directory locked. */
+class Segment {
+public:
+    /** Constructor.
+     * Opens the SMO, creating it if it does not already exist, and sets up
+     * the directory and heap if it is new.
+     * @param name The name/identifier of the POSIX shared memory object.
+     * @param bytes The size of the SMO, including the directory.
+     * @param objects The number of named objects to make room for in the
+     * directory, which is sized so that it is at most half full.
+     * @note It is advised to use @ref formatName on the name used.
+     * @throws std::invalid_argument if @a bytes is too small for the
+     * directory. */
+    inline Segment(const std::string& name, size_t bytes, size_t objects = 256,
+        Permissions perm = Permissions::ReadWrite, const Options& opts = Options());
+
+    /** Constructor.
+     * Attaches to an existing segment, taking its size from the SMO, and
+     * waits until its creator has set it up.
+     * @param name The name/identifier of the POSIX shared memory object.
+     * @throws FileError if the SMO does not exist. */
+    inline Segment(const std::string& name, Permissions perm = Permissions::ReadWrite,
+        const Options& opts = Options());
+
+    ~Segment() = default;
+
+    /** Handles are move-only. A moved-from handle must not be used. */
+    Segment(Segment&&) = default;
+    Segment& operator=(Segment&&) = default;
+    Segment(const Segment&) = delete;
+    Segment& operator=(const Segment&) = delete;
+
+    /** @returns The object called @a name, constructing it from @a args
+     * first if it does not exist yet. Concurrent callers construct it once.
+     * @throws FileError if the handle is read-only; use @ref find instead.
+     * @throws LayoutError if @a name exists with a different type.
+     * @throws std::bad_alloc if the segment is full.
+     * @throws std::length_error if the directory is full. */
+    template<class Tp, class... Args>
+    Tp& find_or_construct(const std::string& name, Args&&... args)
+    {
+        static_assert(alignof(Tp) <= _HeapControl::align,
+            "Segment objects are only 16-byte aligned");
+
+        // Even finding takes the directory's lock
+        this->_obj->check_writable("construct objects");
+        const auto type {_layout_of<Tp>()};
+        std::lock_guard<_FutexLock> guard {this->directory().lock};
+
+        if (const auto found {this->lookup(name, type)})
+            return *static_cast<Tp*>(found);
+
+        const auto p {this->allocate(sizeof(Tp))};
+        Tp* obj;
+        try {
+            obj = ::new (p) Tp(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            this->deallocate(p);
+            throw;
+        }
+
+        try {
+            this->insert(name, type, obj);
+        }
+        catch (...) {
+            obj->~Tp();
+            this->deallocate(p);
+            throw;
+        }
+
+        return *obj;
+    }
+
+    /** @returns The object called @a name, or `nullptr` if there is none.
+     * @throws LayoutError if @a name exists with a different type. */
+    template<class Tp>
+    Tp* find(const std::string& name)
+        { return static_cast<Tp*>(this->lookup(name, _layout_of<Tp>())); }
+    template<class Tp>
+    const Tp* find(const std::string& name) const
+        { return static_cast<const Tp*>(this->lookup(name, _layout_of<Tp>())); }
+
+    /** @returns An allocator for standard containers in the segment, e.g.
+     * for containers that are themselves named objects. */
+    template<class Tp>
+    Allocator<Tp> allocator() noexcept
+        { return Allocator<Tp>(this->heap()); }
+
+    /** @returns @a bytes of unnamed memory from the segment.
+     * @throws std::bad_alloc if the segment is full.
+     * @throws FileError if the handle is read-only. */
+    inline void* allocate(size_t bytes);
+
+    /** Frees memory returned by @ref allocate. */
+    inline void deallocate(void* p) noexcept
+        { this->heap().deallocate(p); }
+
+    /** @returns The number of named objects. */
+    inline size_t count() const noexcept
+        { return this->directory().count.load(std::memory_order_acquire); }
+
+    /** @returns The number of bytes free for objects.
+     * @note The value may be stale by the time it is used. */
+    inline size_t free_bytes() const noexcept
+    {
+        return reinterpret_cast<const volatile _HeapControl*>(
+            this->base() + heap_offset)->free_bytes;
+    }
+
+private:
+    enum : size_t {
+        /** Offset of the heap, after the directory. */
+        heap_offset = _cache_line_size
+    };
+
+    /** A directory entry, published by setting @ref ready. */
+    struct _Entry {
+        std::atomic<uint32_t> ready;
+        uint32_t name_size;
+        uint64_t hash;
+        uint64_t type;
+        offset_ptr<const char> name;
+        offset_ptr<void> object;
+    };
+
+    /** Directory at the start of the SMO: an open-addressed hash table of
+     * entries, probed linearly, in the heap. */
+    struct _Directory {
+        _FutexLock lock;
+        std::atomic<uint32_t> count;
+        uint64_t mask;
+        offset_ptr<_Entry> entries;
+    };
+
+    static_assert(sizeof(_Directory) <= heap_offset, "Segment directory too large");
+
+    /** @returns @a bytes, if enough for the directory and heap.
+     * @throws std::invalid_argument otherwise. */
+    static inline size_t checked_size(size_t bytes, size_t objects);
+
+    /** Sets up the directory and heap once, or waits for them.
+     * @param objects The maximum number of named objects, or 0 to wait. */
+    inline void init(size_t objects);
+
+    /** @returns The object called @a name, or `nullptr`.
+     * @throws LayoutError if its type is not @a type. */
+    inline void* lookup(const std::string& name, uint64_t type) const;
+
+    /** Adds @a obj to the directory as @a name. The lock must be held. */
+    inline void insert(const std::string& name, uint64_t type, void* obj);
+
+    inline const char* base() const noexcept
+        { return static_cast<const char*>(this->_obj->get()); }
+    inline _Directory& directory() noexcept
+        { return *static_cast<_Directory*>(this->_obj->get()); }
+    inline const _Directory& directory() const noexcept
+        { return *static_cast<const _Directory*>(this->_obj->get()); }
+    inline _HeapControl& heap() noexcept
+        { return *reinterpret_cast<_HeapControl*>(static_cast<char*>(this->_obj->get()) + heap_offset); }
+
+    std::shared_ptr<_SharedMemoryObject> _obj;
+};
+
+
+/** Class for a fixed-capacity hash map in a POSIX shared memory object
+ * (SMO), shared between processes.
+ * Buckets are found by open addressing with linear probing. Each bucket has
+ * a version counter: claiming an empty bucket is a CAS on it, and updating a
+ * value is a sequence lock on it, so lookups take no locks and make no
+ * system calls, and need only read permissions.
+ * Keys are never removed.
+ * @tparam K The key type. Must be trivially copyable, and @a Hash must
+ * give the same result for it in every process.
+ * @tparam V The value type. Must be trivially copyable.
+ * @tparam N The number of buckets. Must be a power of two; keep the map at
+ * most about half full for short probes.
+ * @note A process that dies while writing a bucket leaves readers of that
+ * bucket waiting. */
+template<class K, class V, size_t N, class Hash = std::hash<K>, class KeyEqual = std::equal_to<K>>
+class HashMap {
+public:
+    static_assert(N > 0 && (N & (N - 1)) == 0, "HashMap capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<K>::value,
+        "HashMap key type must be trivially copyable");
+    static_assert(std::is_trivially_copyable<V>::value,
+        "HashMap value type must be trivially copyable");
+
+    /** Constructor.
+     * Opens the SMO, creating it if it does not already exist.
+     * A newly created (zero-filled) SMO is a valid, empty map.
+     * @param name The name/identifier of the POSIX shared memory object.
+     * @note It is advised to use @ref formatName on the name used. */
+    HashMap(const std::string& name, Permissions perm = Permissions::ReadWrite,
+        const Options& opts = Options()):
+    _obj{_SharedMemoryObject::acquire(name, sizeof(_Layout), perm, opts, _layout_of<_Layout>())}
+    {}
+
+    ~HashMap() = default;
+
+    /** Handles are move-only. A moved-from handle must not be used. */
+    HashMap(HashMap&&) = default;
+    HashMap& operator=(HashMap&&) = default;
+    HashMap(const HashMap&) = delete;
+    HashMap& operator=(const HashMap&) = delete;
+
+    /** Inserts @a key with @a value, unless the key is already present.
+     * @returns `false` if the key is present or the map is full.
+     * @throws FileError if the handle is read-only. */
+    inline bool insert(const K& key, const V& value);
+
+    /** Replaces the value of @a key, if present.
+     * @returns `false` if the key is not present.
+     * @throws FileError if the handle is read-only. */
+    inline bool assign(const K& key, const V& value);
+
+    /** Copies the value of @a key into @a value. Lock-free.
+     * @returns `false` if the key is not present. */
+    inline bool find(const K& key, V& value) const noexcept;
+
+    /** @returns `true` if @a key is present. */
+    inline bool contains(const K& key) const noexcept
+        { return this->bucket(key) != nullptr; }
+
+    /** @returns The number of keys in the map.
+     * @note The value may be stale by the time it is used. */
+    inline size_t size() const noexcept
+        { return this->layout().count.load(std::memory_order_acquire); }
+
+    /** @returns @ref N; the maximum number of keys in the map. */
+    constexpr size_t capacity() const noexcept
+        { return N; }
+
+private:
+    static constexpr size_t mask {N - 1};
+
+    /** A bucket. Its version is 0 while empty, odd while being written,
+     * and even once the key is set, so that a zero-filled bucket is empty. */
+    struct _Bucket {
+        std::atomic<uint32_t> version;
+        K key;
+        V value;
+    };
+
+    /** Layout of the SMO. */
+    struct _Layout {
+        alignas(_cache_line_size) std::atomic<size_t> count;
+        alignas(_cache_line_size) _Bucket buckets[N];
+    };
+
+    /** @returns The bucket at which the probe for @a key starts. */
+    static inline size_t home(const K& key) noexcept
+    {
+        // Spread hashes that are poor in their low bits, e.g. identities
+        uint64_t h {Hash()(key)};
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return static_cast<size_t>(h) & mask;
+    }
+
+    /** @returns The even version of a bucket after @a version, skipping 0. */
+    static inline uint32_t next_version(uint32_t version) noexcept
+        { return version + 2 == 0 ? 2 : version + 2; }
+
+    /** @returns The version of @a b once it is not being written. */
+    static inline uint32_t stable_version(const _Bucket& b) noexcept;
+
+    /** @returns The bucket holding @a key, or `nullptr`. */
+    inline const _Bucket* bucket(const K& key) const noexcept;
+
+    inline _Layout& layout() noexcept
+        { return *static_cast<_Layout*>(this->_obj->get()); }
+    inline const _Layout& layout() const noexcept
+        { return *static_cast<const _Layout*>(this->_obj->get()); }
+
+    std::shared_ptr<_SharedMemoryObject> _obj;
+};
+
+
+/** Mutex for placing in shared memory, e.g. in an @ref Object or a
+ * @ref Segment, to coordinate the processes sharing it.
+ * A process-shared, robust `pthread` mutex: locking and unlocking make no
+ * system calls unless contended, and if a process dies holding it, the
+ * next process to lock it is told so and can repair the data it protects
+ * (see @ref lock(Recover&&)), rather than waiting forever.
+ * It must be constructed once, e.g. with @ref Object::emplace or
+ * @ref Segment::find_or_construct; a zero-filled Mutex is not robust.
+ * Meets the Lockable requirements, so works with `std::lock_guard` and
+ * `std::unique_lock`. */
+class Mutex {
+public:
+    /** Constructor.
+     * @param priority_inherit Whether a holder is boosted to the priority of
+     * the highest priority waiter (`PTHREAD_PRIO_INHERIT`), avoiding
+     * priority inversion between real-time processes. Contended locking
+     * then always goes through the kernel.
+     * @throws LockError if the mutex cannot be initialised, e.g. if priority
+     * inheritance is not supported. */
+    inline explicit Mutex(bool priority_inherit = false);
+
+    /** Must only be run once no process uses the mutex. */
+    ~Mutex()
+        { pthread_mutex_destroy(&this->_mutex); }
+
+    Mutex(const Mutex&) = delete;
+    Mutex& operator=(const Mutex&) = delete;
+
+    /** Locks the mutex, waiting while another process or thread holds it.
+     * If its previous holder died holding it, @a recover is called with the
+     * lock held: it should make the protected data consistent and return
+     * `true`, after which the mutex is usable as normal. If it returns
+     * `false` or throws, the mutex is released and can never be locked
+     * again.
+     * @throws LockError if the mutex was abandoned by a failed recovery,
+     * or @a recover returned `false`. */
+    template<class Recover>
+    void lock(Recover&& recover)
+    {
+        this->recover_if(pthread_mutex_lock(&this->_mutex), std::forward<Recover>(recover));
+    }
+
+    /** Locks the mutex, as @ref lock(Recover&&), assuming that the
+     * protected data is consistent if the previous holder died. */
+    inline void lock()
+        { this->lock([]() { return true; }); }
+
+    /** Locks the mutex if it is free, as @ref lock(Recover&&).
+     * @returns `false` if it is held. */
+    template<class Recover>
+    bool try_lock(Recover&& recover)
+    {
+        const auto code {pthread_mutex_trylock(&this->_mutex)};
+        if (code == EBUSY)
+            return false;
+
+        this->recover_if(code, std::forward<Recover>(recover));
+        return true;
+    }
+
+    inline bool try_lock()
+        { return this->try_lock([]() { return true; }); }
+
+    /** Unlocks the mutex, which must be held by this thread. */
+    inline void unlock() noexcept
+        { pthread_mutex_unlock(&this->_mutex); }
+
+private:
+    /** Handles the result @a code of locking: on `EOWNERDEAD`, runs
+     * @a recover and marks the mutex consistent if it succeeds.
+     * @throws LockError if the mutex is not locked in the end. */
+    template<class Recover>
+    void recover_if(int code, Recover&& recover)
+    {
+        if (code == EOWNERDEAD) {
+            bool recovered {false};
+            try {
+                recovered = recover();
+            }
+            catch (...) {
+                this->unlock();
+                throw;
+            }
+
+            if (!recovered) {
+                this->unlock();
+                throw LockError("Mutex: recovery failed after its holder died");
+            }
+
+            pthread_mutex_consistent(&this->_mutex);
+        }
+        else if (code != 0) {
+            throw LockError(code == ENOTRECOVERABLE
+                ? "Mutex: not recoverable, its holder died and recovery failed"
+                : "Mutex: could not lock: error code " + std::to_string(code));
+        }
+    }
+
+    pthread_mutex_t _mutex;
+};
+
+
+/** Sends the file descriptor @a fd over the connected Unix domain socket
+ * @a socket (as `SCM_RIGHTS` ancillary data), so that the receiving process
+ * can attach to the same shared memory.
+ * @throws FileError if sending fails. */
+inline void sendDescriptor(int socket, int fd);
+
+/** Receives a file descriptor sent with @ref sendDescriptor over the Unix
+ * domain socket @a socket. Blocks until one arrives.
+ * @returns The new descriptor, owned by the caller.
+ * @throws FileError if receiving fails, or the peer closed the socket. */
+inline int receiveDescriptor(int socket);
+
+/** Tests whether a SMO called @a name exists.
+ * @note This test will also fail if the memory fails to open for reasons such
+ * as process- or system-wide limits on file openings being reached. */
+inline bool exists(const std::string& name);
+
+/** Formats the identifier name according to the naming conventions outlined at
+ * https://www.man7.org/linux/man-pages/man3/shm_open.3.html#DESCRIPTION. */
+inline std::string formatName(const std::string& name);
+
+} // namespace shm
+
+// END OF API HEADER
+////////////////////////////////////////////////////////////////////////////////
+// START OF IMPLEMENTATION
+
+namespace shm {
+
+// struct _SegmentHeader
+
+/** Pauses briefly inside a spin loop. */
+inline void _cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/** Sleeps until @a word no longer holds @a expected, a wake-up is issued
+ * on it, or @a timeout (if not `nullptr`) expires. May return spuriously. */
+inline void _futex_wait(const std::atomic<uint32_t>& word, uint32_t expected,
+    const std::chrono::nanoseconds* timeout) noexcept
+{
+#ifdef __linux__
+    timespec ts;
+    if (timeout != nullptr) {
+        ts.tv_sec = static_cast<time_t>(timeout->count() / 1000000000);
+        ts.tv_nsec = static_cast<long>(timeout->count() % 1000000000);
+    }
+
+    // Not FUTEX_PRIVATE_FLAG: the word is shared between processes
+    syscall(SYS_futex, &word, FUTEX_WAIT, expected,
+        timeout != nullptr ? &ts : nullptr, nullptr, 0);
+#else
+    // No futexes: fall back to polling at a modest rate
+    (void)expected;
+    auto nap {std::chrono::nanoseconds(std::chrono::microseconds(50))};
+    if (timeout != nullptr && *timeout < nap)
+        nap = *timeout;
+    std::this_thread::sleep_for(nap);
+#endif
+}
+
+/** Wakes every process sleeping in @ref _futex_wait on @a word. */
+inline void _futex_wake(std::atomic<uint32_t>& word) noexcept {
+#ifdef __linux__
+    syscall(SYS_futex, &word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+void _SegmentHeader::notify() noexcept {
+    this->change_seq.fetch_add(1, std::memory_order_release);
+    _futex_wake(this->change_seq);
+}
+
+bool _SegmentHeader::wait(uint32_t& seen, unsigned spins,
+    const std::chrono::nanoseconds* timeout) const noexcept
+{
+    // Hot path: poll for a while before going to sleep
+    for (unsigned i {0}; i < spins; i++) {
+        const auto cur {this->change_seq.load(std::memory_order_acquire)};
+        if (cur != seen) {
+            seen = cur;
+            return true;
+        }
+        _cpu_relax();
+    }
+
+    const auto deadline {std::chrono::steady_clock::now()
+        + (timeout != nullptr ? *timeout : std::chrono::nanoseconds::zero())};
+
+    while (true) {
+        const auto cur {this->change_seq.load(std::memory_order_acquire)};
+        if (cur != seen) {
+            seen = cur;
+            return true;
+        }
+
+        if (timeout == nullptr) {
+            _futex_wait(this->change_seq, seen, nullptr);
+        }
+        else {
+            const auto remaining {deadline - std::chrono::steady_clock::now()};
+            if (remaining <= std::chrono::nanoseconds::zero())
+                return false;
+
+            const std::chrono::nanoseconds t {
+                std::chrono::duration_cast<std::chrono::nanoseconds>(remaining)
+            };
+            _futex_wait(this->change_seq, seen, &t);
+        }
+    }
+}
+
+bool _SegmentHeader::begin_construction() noexcept {
+    while (true) {
+        auto state {this->init_state.load(std::memory_order_acquire)};
+
+        if (state == constructed)
+            return false;
+
+        if (state == uninit) {
+            if (this->init_state.compare_exchange_weak(state, constructing,
+                std::memory_order_acquire))
+                return true;
+        }
+        else {
+            // Sleep on the state word, never on the data being constructed
+            _futex_wait(this->init_state, state, nullptr);
+        }
+    }
+}
+
+void _SegmentHeader::end_construction(bool success) noexcept {
+    this->init_state.store(success ? constructed : uninit, std::memory_order_release);
+    _futex_wake(this->init_state);
+}
+
+void _SegmentHeader::wait_constructed() const noexcept {
+    while (true) {
+        const auto state {this->init_state.load(std::memory_order_acquire)};
+        if (state == constructed)
+            return;
+        _futex_wait(this->init_state, state, nullptr);
+    }
+}
+
+
+// class _SharedMemoryObject
+
+/** @returns @a n rounded up to a multiple of @a align. */
+inline size_t _round_up(size_t n, size_t align) noexcept {
+    return (n + align - 1) / align * align;
+}
+
+/** @returns The size of a transparent huge page, in bytes. */
+inline size_t _transparent_huge_page_size() {
+    size_t sz {0};
+    std::ifstream f {"/sys/kernel/mm/transparent_hugepage/hpage_pmd_size"};
+    f >> sz;
+    return sz > 0 ? sz : 2 * 1024 * 1024;
+}
+
+/** @returns The offset of the user data in a SMO opened with @a opts. */
+inline size_t _data_offset_for(const Options& opts) {
+    return opts.mirror ? static_cast<size_t>(sysconf(_SC_PAGESIZE)) : sizeof(_SegmentHeader);
+}
+
+/** @returns @a opts, less anything that cannot be combined with the rest. */
+inline Options _effective(Options opts) {
+    // Huge pages would break the page-granular mirror
+    if (opts.mirror)
+        opts.huge_pages = HugePages::None;
+    return opts;
+}
+
+inline _SharedMemoryObject::_SharedMemoryObject(const std::string& nm, size_t size,
+    Permissions perm, const Options& opts):
+_data{nullptr},
+_name{nm},
+_perm{perm},
+_data_offset{_data_offset_for(opts)},
+_size{size > 0 ? _data_offset + size : 0},
+_data_size{size},
+_huge_pages{opts.mirror ? HugePages::None : opts.huge_pages},
+_opts{_effective(opts)},
+_created{false},
+_counted{false},
+_pid{getpid()},
+_from_descriptor{false},
+_sealed{false},
+_sysv_id{-1},
+_flusher_stop{false},
+_prefault_time{0},
+fd{-1}
+{
+    try {
+        this->init(size);
+    }
+    catch (...) {
+        this->unmap();
+        this->close();
+        // Don't leave behind a SMO nobody could use
+        if (this->_created && this->is_named())
+            this->unlink();
+        throw;
+    }
+}
+
+inline _SharedMemoryObject::_SharedMemoryObject(int descriptor, size_t size,
+    Permissions perm, const Options& opts):
+_data{nullptr},
+_name{"descriptor " + std::to_string(descriptor)},
+_perm{perm},
+_data_offset{_data_offset_for(opts)},
+_size{size > 0 ? _data_offset + size : 0},
+_data_size{size},
+_huge_pages{HugePages::None},
+_opts{_effective(opts)},
+_created{false},
+_counted{false},
+_pid{getpid()},
+_from_descriptor{true},
+_sealed{false},
+_sysv_id{-1},
+_flusher_stop{false},
+_prefault_time{0},
+fd{fcntl(descriptor, F_DUPFD_CLOEXEC, 0)}
+{
+    if (this->fd == -1)
+        throw FileError("Shared memory: could not duplicate " + this->_name +
+            ": error code " + std::to_string(errno));
+
+    try {
+        this->init(size);
+    }
+    catch (...) {
+        this->unmap();
+        this->close();
+        throw;
+    }
+}
+
+inline void _SharedMemoryObject::init(size_t size) {
+    const auto deadline {std::chrono::steady_clock::now() + std::chrono::seconds(1)};
+
+    while (!this->attach()) {
+        // The last counted detacher is removing the SMO; wait for the name
+        // to be freed, so the next attempt creates a fresh one
+        if (std::chrono::steady_clock::now() > deadline)
+            throw FileError("Shared memory: could not attach to " + this->_name +
+                ": it is being removed");
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (this->_opts.populate || this->_opts.pretouch_threads > 0 || this->_opts.lock) {
+        // Added to the time map spent populating the mapping, if any
+        const auto start {std::chrono::steady_clock::now()};
+        this->prefault();
+        this->_prefault_time += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start
+        );
+    }
+
+    if (size > 0) {
+        if (this->is_writable()) {
+            // The SMO only ever grows, so record the largest size requested
+            auto recorded {this->header().data_size.load(std::memory_order_relaxed)};
+            while (recorded < size
+                && !this->header().data_size.compare_exchange_weak(recorded, size,
+                    std::memory_order_relaxed)) {}
+        }
+    }
+    else {
+        // Discovered: prefer the size recorded by the writer to the (possibly
+        // rounded-up) size of the SMO
+        const auto recorded {this->header().data_size.load(std::memory_order_relaxed)};
+        this->_data_size = recorded > 0 && recorded <= this->_size - this->_data_offset
+            ? recorded
+            : this->_size - this->_data_offset;
+    }
+
+    if (this->_opts.flush_interval.count() > 0 && this->is_writable())
+        this->start_flusher();
+}
+
+inline std::shared_ptr<_SharedMemoryObject> _SharedMemoryObject::acquire(
+    const std::string& name, size_t size, Permissions perm, const Options& opts,
+    uint64_t layout)
+{
+    auto obj {_SharedMemoryObject::find_or_map(name, size, perm, opts)};
+    if (opts.check_layout)
+        obj->check_layout(_fnv_mix(layout, opts.layout_version));
+    return obj;
+}
+
+inline std::shared_ptr<_SharedMemoryObject> _SharedMemoryObject::find_or_map(
+    const std::string& name, size_t size, Permissions perm, const Options& opts)
+{
+    // Each mapping, and the object owning it while it is alive, ordered so
+    // that the mappings of one SMO are adjacent
+    using Registry = std::map<std::string,
+        std::pair<const _SharedMemoryObject*, std::weak_ptr<_SharedMemoryObject>>>;
+
+    // Process-wide, as function-local statics of inline functions are shared
+    // between translation units
+    static std::mutex mutex;
+    static std::condition_variable torn_down;
+    static Registry registry;
+
+    // Unnamed memory cannot be found again, so is never shared
+    if (!_is_named(opts.backend))
+        return std::make_shared<_SharedMemoryObject>(name, size, perm, opts);
+
+    // Only share mappings made with the same options
+    const auto smo {std::to_string(static_cast<int>(opts.backend)) + ',' + name + '\n'};
+    const auto key {smo
+        + (perm == Permissions::ReadOnly ? ",ro," : ",rw,")
+        + std::to_string(static_cast<int>(opts.lifetime)) + ','
+        + std::to_string(static_cast<int>(opts.huge_pages)) + ',' + opts.hugetlbfs_path + ','
+        + std::to_string(opts.populate) + ',' + std::to_string(opts.pretouch_threads) + ','
+        + std::to_string(opts.lock) + ',' + std::to_string(opts.flush_interval.count()) + ','
+        + std::to_string(opts.seal) + ',' + std::to_string(opts.mirror)};
+
+    // Tear the mapping down under the lock when its last handle goes
+    const auto deleter = [key](_SharedMemoryObject* obj) {
+        std::lock_guard<std::mutex> guard {mutex};
+
+        const auto entry {registry.find(key)};
+        if (entry != registry.end() && entry->second.first == obj)
+            registry.erase(entry);
+
+        delete obj;
+        torn_down.notify_all();
+    };
+
+    // Declared before the lock, so released after it: either may be the last
+    // handle, whose deleter takes the lock
+    std::shared_ptr<_SharedMemoryObject> existing;
+    std::shared_ptr<_SharedMemoryObject> obj;
+    std::unique_lock<std::mutex> lock {mutex};
+
+    // A mapping of the SMO whose last handle has gone may still be being
+    // torn down: wait, so that it cannot remove the SMO after we open it
+    const auto tearing_down = [&smo]() {
+        for (auto e {registry.lower_bound(smo)};
+            e != registry.end() && e->first.compare(0, smo.size(), smo) == 0; ++e) {
+            if (e->second.second.expired())
+                return true;
+        }
+        return false;
+    };
+
+    while (true) {
+        while (tearing_down())
+            torn_down.wait(lock);
+
+        const auto it {registry.find(key)};
+
+        // Creating must always open the SMO, to detect that it already exists
+        if (opts.open_mode == OpenMode::Create || it == registry.end())
+            break;
+
+        existing = it->second.second.lock();
+        if (existing && existing->size() >= size)
+            return existing;
+
+        // Handles are released without the lock, so its last one may have
+        // gone since we checked: wait for that teardown too
+        if (existing)
+            break;
+    }
+
+    obj.reset(new _SharedMemoryObject(name, size, perm, opts), deleter);
+    registry[key] = std::make_pair(obj.get(), std::weak_ptr<_SharedMemoryObject>(obj));
+    return obj;
+}
+
+inline std::shared_ptr<_SharedMemoryObject> _SharedMemoryObject::acquire(
+    int fd, size_t size, Permissions perm, const Options& opts, uint64_t layout)
+{
+    auto obj {std::make_shared<_SharedMemoryObject>(fd, size, perm, opts)};
+    if (opts.check_layout)
+        obj->check_layout(_fnv_mix(layout, opts.layout_version));
+    return obj;
+}
+
+inline void _SharedMemoryObject::check_writable(const char* operation) const {
+    if (!this->is_writable())
+        throw FileError("Shared memory: cannot " + std::string(operation) + " in " +
+            this->_name + ": opened read-only");
+}
+
+inline void _SharedMemoryObject::check_layout(uint64_t layout) {
+    auto& header {this->header()};
+    auto& state {header.layout_state};
+    const auto deadline {std::chrono::steady_clock::now() + std::chrono::seconds(1)};
+
+    while (true) {
+        auto s {state.load(std::memory_order_acquire)};
+
+        if (s == _SegmentHeader::ready)
+            break;
+
+        if (s == _SegmentHeader::unstamped && this->is_writable()
+            && state.compare_exchange_strong(s, _SegmentHeader::stamping, std::memory_order_acquire))
+        {
+            header.layout.store(layout, std::memory_order_relaxed);
+            header.magic.store(_segment_magic, std::memory_order_relaxed);
+            state.store(_SegmentHeader::ready, std::memory_order_release);
+            return;
+        }
+
+        // Being stamped, or waiting for a writer to stamp it
+        if (std::chrono::steady_clock::now() > deadline)
+            throw LayoutError("Shared memory: layout of " + this->_name +
+                " was not stamped by a writer");
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (header.magic.load(std::memory_order_relaxed) != _segment_magic)
+        throw LayoutError("Shared memory: " + this->_name + " has a corrupt header");
+
+    if (header.layout.load(std::memory_order_relaxed) != layout)
+        throw LayoutError("Shared memory: " + this->_name +
+            " holds data of a different type, size or version");
+}
+
+inline _SharedMemoryObject::~_SharedMemoryObject() {
+    this->stop_flusher();
+
+    bool last {false};
+    // Only the process that opened the SMO may remove it
+    const auto inherited {getpid() != this->_pid};
+
+    switch (this->_opts.lifetime) {
+        case Lifetime::Owner:
+            last = this->_created && !inherited;
+        break;
+        case Lifetime::Persistent:
+        break;
+        case Lifetime::LastDetacher:
+            if (this->_counted && !inherited)
+                last = this->detach();
+        break;
+    }
+
+    this->unmap();
+    this->close();
+
+    if (last && this->is_named())
+        this->unlink();
+}
+
+inline bool _SharedMemoryObject::attach() {
+    const auto size {this->_size};
+
+    if (this->_opts.mirror && !this->_from_descriptor
+        && (this->_opts.backend == Backend::SysV || this->_opts.backend == Backend::Anonymous))
+        throw MemoryError("Shared memory: cannot mirror " + this->_name +
+            ": the backend has no file descriptor");
+
+    if (this->_from_descriptor) {
+        // Keep the descriptor open, so it can be passed on
+        this->open_descriptor();
+        this->map();
+    }
+    else if (this->_opts.backend == Backend::Memfd) {
+        this->open_memfd();
+    }
+    else if (this->_opts.backend == Backend::Anonymous) {
+        this->map_anonymous();
+    }
+    else if (this->_opts.backend == Backend::SysV) {
+        this->open_sysv();
+        this->map_sysv();
+    }
+    else if (this->_opts.backend == Backend::PosixShm
+        && this->_opts.huge_pages == HugePages::Explicit
+        && this->open_hugetlbfs(this->_opts.hugetlbfs_path)) {
+        // Already mapped
+    }
+    else {
+        if (this->_opts.backend == Backend::File)
+            this->_path = this->_name;
+
+        this->_huge_pages = this->_opts.huge_pages;
+        if (this->_huge_pages == HugePages::Explicit)
+            this->_huge_pages = HugePages::Transparent;
+
+        if (this->_huge_pages == HugePages::Transparent && this->_size > 0)
+            this->_size = _round_up(this->_size, _transparent_huge_page_size());
+
+        this->open();
+        this->map();
+        this->close();
+    }
+
+    // Unnamed memory disappears with its last mapping anyway
+    this->_counted = this->_opts.lifetime == Lifetime::LastDetacher
+        && this->is_writable() && this->is_named();
+    if (!this->_counted)
+        return true;
+
+    auto& count {this->header().attach_count};
+    auto n {count.load(std::memory_order_relaxed)};
+
+    while (true) {
+        if (n == _SegmentHeader::detached) {
+            // Too late: undo, and let the caller retry
+            this->unmap();
+            this->_size = size;
+            this->_created = false;
+            this->_path.clear();
+            this->_sysv_id = -1;
+            return false;
+        }
+
+        if (count.compare_exchange_weak(n, n + 1, std::memory_order_acq_rel))
+            return true;
+    }
+}
+
+inline bool _SharedMemoryObject::detach() {
+    auto& count {this->header().attach_count};
+    auto n {count.load(std::memory_order_relaxed)};
+
+    while (true) {
+        // The last one out marks the SMO as dead, so no-one can revive it
+        // between our decrement and unlink
+        const auto next {n <= 1 ? _SegmentHeader::detached : n - 1};
+
+        if (count.compare_exchange_weak(n, next, std::memory_order_acq_rel))
+            return next == _SegmentHeader::detached;
+    }
+}
+
+inline void _SharedMemoryObject::open_memfd() {
+#ifndef MFD_CLOEXEC
+    throw FileError("Shared memory: memfd_create is not supported on this platform");
+#else
+    if (this->_size == 0)
+        throw FileError("Shared memory: cannot create memfd " + this->_name + " without a size");
+
+    const unsigned flags {MFD_CLOEXEC | MFD_ALLOW_SEALING};
+    this->_huge_pages = this->_opts.huge_pages;
+
+    if (this->_huge_pages == HugePages::Explicit) {
+        const auto requested {this->_size};
+        this->fd = memfd_create(this->_name.c_str(), flags | MFD_HUGETLB);
+
+        if (this->fd != -1) {
+            try {
+                // The filesystem's block size is its huge page size
+                struct statfs fs;
+                if (fstatfs(this->fd, &fs) == -1)
+                    throw FileError("Shared memory: could not get the page size of " + this->_name);
+
+                this->_size = _round_up(this->_size, static_cast<size_t>(fs.f_bsize));
+                this->resize();
+                this->map();
+                this->_created = true;
+                this->seal();
+                return;
+            }
+            catch (const std::runtime_error&) {
+                // Most likely no free huge pages: undo everything
+                this->close();
+                this->_data = nullptr;
+                this->_size = requested;
+            }
+        }
+
+        this->_huge_pages = HugePages::Transparent;
+    }
+
+    if (this->_huge_pages == HugePages::Transparent)
+        this->_size = _round_up(this->_size, _transparent_huge_page_size());
+
+    this->fd = memfd_create(this->_name.c_str(), flags);
+
+    if (this->fd == -1) {
+        std::string msg {"Shared memory: could not create memfd " + this->_name};
+
+        switch (errno) {
+            case EINVAL:
+                msg.append(": invalid name");
+            break;
+            case EMFILE:
+            case ENFILE:
+                msg.append(": too many files open");
+            break;
+            case ENOMEM:
+                msg.append(": no memory available");
+            break;
+            default:
+                msg.append(": error code " + std::to_string(errno));
+            break;
+        }
+
+        throw FileError(msg);
+    }
+
+    this->_created = true;
+    this->resize();
+    this->map();
+    this->seal();
+#endif
+}
+
+inline void _SharedMemoryObject::map_anonymous() {
+    if (this->_size == 0)
+        throw FileError("Shared memory: cannot create anonymous memory " + this->_name +
+            " without a size");
+
+    this->_created = true;
+    this->_huge_pages = this->_opts.huge_pages;
+
+    if (this->_huge_pages == HugePages::Explicit) {
+#ifdef MAP_HUGETLB
+        const auto requested {this->_size};
+        this->_size = _round_up(this->_size, _transparent_huge_page_size());
+
+        try {
+            this->map();
+            return;
+        }
+        catch (const MemoryError&) {
+            // No free huge pages
+            this->_data = nullptr;
+            this->_size = requested;
+        }
+#endif
+        this->_huge_pages = HugePages::Transparent;
+    }
+
+    if (this->_huge_pages == HugePages::Transparent)
+        this->_size = _round_up(this->_size, _transparent_huge_page_size());
+
+    this->map();
+}
+
+inline void _SharedMemoryObject::seal() {
+#ifdef F_ADD_SEALS
+    if (this->_opts.seal)
+        this->_sealed = fcntl(this->fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != -1;
+#endif
+}
+
+inline void _SharedMemoryObject::open_descriptor() {
+#ifdef F_GET_SEALS
+    const auto seals {fcntl(this->fd, F_GET_SEALS)};
+    this->_sealed = seals != -1 && (seals & F_SEAL_SHRINK) != 0;
+#endif
+
+    struct stat st;
+
+    if (fstat(this->fd, &st) == -1) {
+        const auto code {errno};
+        this->close();
+        throw FileError(
+            "Shared memory: could not get the size of " + this->_name +
+            ": error code " + std::to_string(code)
+        );
+    }
+
+    if (this->_size == 0) {
+        if (static_cast<size_t>(st.st_size) <= this->_data_offset) {
+            this->close();
+            throw FileError(
+                "Shared memory: could not attach to " + this->_name +
+                ": no data (size " + std::to_string(st.st_size) + " bytes)"
+            );
+        }
+
+        this->_size = static_cast<size_t>(st.st_size);
+    }
+    else if (static_cast<size_t>(st.st_size) < this->_size) {
+        // Never resize memory we were handed
+        this->close();
+        throw FileError(
+            "Shared memory: could not attach to " + this->_name +
+            ": size " + std::to_string(st.st_size) +
+            " bytes is smaller than expected (" + std::to_string(this->_size) + " bytes)"
+        );
+    }
+}
+
+inline key_t _sysv_key(const std::string& name) noexcept {
+    // FNV-1a
+    uint32_t hash {2166136261u};
+    for (const auto c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+
+    const auto key {static_cast<key_t>(hash & INT32_MAX)};
+    return key == IPC_PRIVATE ? 1 : key;
+}
+
+inline void _SharedMemoryObject::open_sysv() {
+    const auto key {_sysv_key(this->_name)};
+    const int mode {S_IRWXU | S_IRGRP};
+    // Readers never create the segment, only attach to it
+    const auto open_mode {this->is_writable() ? this->_opts.open_mode : OpenMode::Open};
+    const auto may_create {this->_size > 0 && open_mode != OpenMode::Open};
+    const auto may_attach {this->_size == 0 || open_mode != OpenMode::Create};
+
+    this->_huge_pages = this->_opts.huge_pages;
+#ifndef SHM_HUGETLB
+    if (this->_huge_pages == HugePages::Explicit)
+        this->_huge_pages = HugePages::Transparent;
+#endif
+
+    while (true) {
+        if (may_create) {
+            const int flags {IPC_CREAT | IPC_EXCL | mode};
+#ifdef SHM_HUGETLB
+            if (this->_huge_pages == HugePages::Explicit) {
+                const auto huge_size {_round_up(this->_size, _transparent_huge_page_size())};
+                this->_sysv_id = shmget(key, huge_size, flags | SHM_HUGETLB);
+
+                if (this->_sysv_id != -1)
+                    this->_size = huge_size;
+                else if (errno != EEXIST)
+                    // Most likely no free huge pages
+                    this->_huge_pages = HugePages::Transparent;
+            }
+#endif
+            if (this->_huge_pages == HugePages::Transparent)
+                this->_size = _round_up(this->_size, _transparent_huge_page_size());
+
+            if (this->_huge_pages != HugePages::Explicit)
+                this->_sysv_id = shmget(key, this->_size, flags);
+
+            if (this->_sysv_id != -1) {
+                this->_created = true;
+                return;
+            }
+            if (errno != EEXIST || !may_attach)
+                this->throw_open_error();
+        }
+
+        this->_sysv_id = shmget(key, 0, 0);
+        if (this->_sysv_id != -1)
+            break;
+
+        // Removed between our attempts to create and to attach: try again
+        if (errno != ENOENT || !may_create)
+            this->throw_open_error();
+    }
+
+    struct shmid_ds ds;
+
+    if (shmctl(this->_sysv_id, IPC_STAT, &ds) == -1) {
+        const auto code {errno};
+        this->_sysv_id = -1;
+        throw FileError(
+            "Shared memory: could not get the size of " + this->_name +
+            ": error code " + std::to_string(code)
+        );
+    }
+
+    const auto actual {static_cast<size_t>(ds.shm_segsz)};
+
+    if (actual <= this->_data_offset || actual < this->_size) {
+        // Segments have a fixed size
+        this->_sysv_id = -1;
+        throw FileError(
+            "Shared memory: could not attach to " + this->_name +
+            ": size " + std::to_string(actual) +
+            " bytes is smaller than expected (" + std::to_string(this->_size) + " bytes)"
+        );
+    }
+
+    // shmat always maps the whole segment
+    this->_size = actual;
+}
+
+inline void _SharedMemoryObject::map_sysv() {
+    this->_data = shmat(this->_sysv_id, nullptr, this->is_writable() ? 0 : SHM_RDONLY);
+
+    if (this->_data == reinterpret_cast<void*>(-1)) {
+        const auto code {errno};
+        this->_data = nullptr;
+        if (this->_created)
+            shmctl(this->_sysv_id, IPC_RMID, nullptr);
+        this->_sysv_id = -1;
+        this->_created = false;
+
+        throw MemoryError(
+            "Shared memory: error attaching segment " + this->_name +
+            (code == EACCES ? ": permission denied" : " error code " + std::to_string(code))
+        );
+    }
+
+    if (this->_huge_pages == HugePages::Transparent) {
+#ifdef MADV_HUGEPAGE
+        if (madvise(this->_data, this->_size, MADV_HUGEPAGE) == -1)
+            this->_huge_pages = HugePages::None;
+#else
+        this->_huge_pages = HugePages::None;
+#endif
+    }
+}
+
+inline int _SharedMemoryObject::open_fd(int oflag, mode_t mode) const {
+    return this->_path.empty()
+        ? shm_open(this->_name.c_str(), oflag, mode)
+        : ::open(this->_path.c_str(), oflag, mode);
+}
+
+inline void _SharedMemoryObject::throw_open_error() const {
+    std::string msg {"Shared memory: could not open " + this->_name};
+
+    switch (errno) {
+        case EACCES:
+            msg.append(": permission denied");
+        break;
+        case EEXIST:
+            msg.append(": already exists");
+        break;
+        case EINVAL:
+            msg.append(": invalid name");
+        break;
+        case EMFILE:
+        case ENFILE:
+            msg.append(": too many files open");
+        break;
+        case ENAMETOOLONG:
+            msg.append(": filename too long");
+        break;
+        case ENOENT:
+            msg.append(": does not exist");
+        break;
+        default:
+            msg.append(": error code " + std::to_string(errno));
+        break;
+    }
+
+    throw FileError(msg);
+}
+
+inline void _SharedMemoryObject::open() {
+    const mode_t mode {S_IRWXU | S_IRGRP};
+    // Readers never create the SMO, only attach to it
+    const auto open_mode {this->is_writable() ? this->_opts.open_mode : OpenMode::Open};
+    // Only create the SMO if we know how big to make it
+    const auto may_create {this->_size > 0 && open_mode != OpenMode::Open};
+    const auto may_attach {this->_size == 0 || open_mode != OpenMode::Create};
+    // Readers attach read-only, so they can never resize or write to the SMO
+    const auto attach_flag {this->is_writable() ? O_RDWR : O_RDONLY};
+
+    while (true) {
+        if (may_create) {
+            this->fd = this->open_fd(O_RDWR | O_CREAT | O_EXCL, mode);
+            if (this->fd != -1) {
+                this->_created = true;
+                break;
+            }
+            if (errno != EEXIST || !may_attach)
+                this->throw_open_error();
+        }
+
+        this->fd = this->open_fd(attach_flag, mode);
+        if (this->fd != -1)
+            break;
+
+        // Unlinked between our attempts to create and to attach: try again
+        if (errno != ENOENT || !may_create)
+            this->throw_open_error();
+    }
+
+#ifdef __linux__
+    if (this->_opts.backend != Backend::File && !this->_path.empty() && this->_size > 0) {
+        // The filesystem's block size is its huge page size
+        struct statfs fs;
+        if (fstatfs(this->fd, &fs) == -1) {
+            this->close();
+            throw FileError("Shared memory: could not get the page size of " + this->_path);
+        }
+        this->_size = _round_up(this->_size, static_cast<size_t>(fs.f_bsize));
+    }
+#endif
+
+    if (this->_created) {
+        this->resize();
+        return;
+    }
+
+    struct stat st;
+    const auto deadline {std::chrono::steady_clock::now() + std::chrono::seconds(1)};
+
+    while (true) {
+        if (fstat(this->fd, &st) == -1) {
+            const auto code {errno};
+            this->close();
+            throw FileError(
+                "Shared memory: could not get the size of " + this->_name +
+                ": error code " + std::to_string(code)
+            );
+        }
+
+        // The creator may not have sized the SMO yet
+        if (static_cast<size_t>(st.st_size) > this->_data_offset
+            || std::chrono::steady_clock::now() > deadline)
+            break;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (this->_size == 0) {
+        // Attaching to an existing SMO: take its size as-is
+        if (static_cast<size_t>(st.st_size) <= this->_data_offset) {
+            this->close();
+            throw FileError(
+                "Shared memory: could not attach to " + this->_name +
+                ": no data (size " + std::to_string(st.st_size) + " bytes)"
+            );
+        }
+
+        this->_size = static_cast<size_t>(st.st_size);
+    }
+    else if (static_cast<size_t>(st.st_size) < this->_size) {
+        if (this->is_writable() && this->_opts.open_mode == OpenMode::CreateOrOpen) {
+            // Grow it to fit our data; a larger SMO is never shrunk under
+            // the processes using it
+            this->resize();
+        }
+        else {
+            // Readers and OpenMode::Open never resize
+            this->close();
+            throw FileError(
+                "Shared memory: could not attach to " + this->_name +
+                ": size " + std::to_string(st.st_size) +
+                " bytes is smaller than expected (" + std::to_string(this->_size) + " bytes)"
+            );
+        }
+    }
+}
+
+inline void _SharedMemoryObject::resize() {
+    const auto err {ftruncate(this->fd, this->_size)};
+
+    if (err == -1) {
+        // error handling
+        std::string msg {
+            "Shared memory: could not create shared memory object " + this->_name +
+            " of size " + std::to_string(this->_size) + " bytes"
+        };
+
+        switch (errno) {
+            case EFBIG:
+                msg.append(": larger than maximum file size");
+            break;
+            case EPERM:
+                msg.append(": permission denied");
+            break;
+            case EINTR:
+                msg.append(": interrupted by signal");
+            break;
+            case EBADF:
+            case EINVAL:
+                msg.append(": internal error");
+            break;
+            default:
+                msg.append(": error code " + std::to_string(errno));
+            break;
+        }
+
+        this->close();
+        throw FileError(msg);
+    }
+}
+
+inline bool _SharedMemoryObject::open_hugetlbfs(const std::string& mount) {
+#ifndef __linux__
+    // hugetlbfs is Linux-specific
+    (void)mount;
+    return false;
+#else
+    const auto requested {this->_size};
+    this->_path = mount
+        + (!this->_name.empty() && this->_name.front() == '/' ? "" : "/") + this->_name;
+
+    try {
+        this->open();
+        this->map();
+    }
+    catch (const std::runtime_error&) {
+        // Most likely no mount, or no free huge pages: undo everything
+        this->close();
+        if (this->_created)
+            ::unlink(this->_path.c_str());
+
+        this->_data = nullptr;
+        this->_created = false;
+        this->_size = requested;
+        this->_path.clear();
+        return false;
+    }
+
+    return true;
+#endif
+}
+
+inline void _SharedMemoryObject::close() {
+    if (this->fd != -1) {
+        // Only close the file if it is open
+        const auto err {::close(this->fd)};
+
+        if (err == -1) {
+            // error handling
+            std::string msg {
+                "Shared memory: error when closing file " + this->_name +
+                " with descriptor " + std::to_string(this->fd)
+            };
+
+            switch (errno) {
+                case EBADF:
+                    msg.append(": internal error");
+                break;
+                case EINTR:
+                    msg.append(": interrupted by signal");
+                break;
+                default:
+                    msg.append(" error code " + std::to_string(errno));
+                break;
+            }
+
+            msg.push_back('\n');
+            std::cerr << msg;
+        }
+    }
+
+    this->fd = -1;
+}
+
+inline void _SharedMemoryObject::unlink() {
+    if (this->_sysv_id != -1) {
+        // Removed once the last process detaches; the key is freed now
+        if (shmctl(this->_sysv_id, IPC_RMID, nullptr) == -1 && errno != EINVAL && errno != EIDRM)
+            std::cerr << "Shared memory: error when removing shared memory " + this->_name +
+                " error code " + std::to_string(errno) + '\n';
+        return;
+    }
+
+    const auto err {this->_path.empty()
+        ? shm_unlink(this->_name.c_str())
+        : ::unlink(this->_path.c_str())};
+
+    if (err == -1) {
+        std::string msg {
+            "Shared memory: error when unlinking shared memory " + this->_name
+        };
+
+        switch (errno) {
+            case EACCES:
+                msg.append(": permission denied");
+            break;
+            case EMFILE:
+            case ENFILE:
+            case ENAMETOOLONG:
+                msg.append(": file error");
+            break;
+            case ENOENT:
+                // Probably already unlinked by another destructor
+                return;
+            break;
+            default:
+                msg.append(" error code " + std::to_string(errno));
+            break;
+        }
+
+        msg.push_back('\n');
+        std::cerr << msg;
+    }
+}
+
+inline void _SharedMemoryObject::map() {
+    if (this->_opts.mirror) {
+        this->map_mirrored();
+        return;
+    }
+
+    const auto prot = [this]{
+        int p = PROT_READ;
+        if (this->is_writable())
+            p |= PROT_WRITE;
+        return p;
+    }();
+    // Shared even for readers, so that futex waits on the header are keyed to
+    // the underlying object rather than to this process' private copy
+    auto flags = MAP_SHARED;
+    if (this->_opts.backend == Backend::Anonymous && !this->_from_descriptor) {
+        flags |= MAP_ANONYMOUS;
+#ifdef MAP_HUGETLB
+        if (this->_huge_pages == HugePages::Explicit)
+            flags |= MAP_HUGETLB;
+#endif
+    }
+#ifdef MAP_POPULATE
+    if (this->_opts.populate)
+        flags |= MAP_POPULATE;
+#endif
+
+    const auto start {std::chrono::steady_clock::now()};
+    this->_data = mmap(NULL, this->_size, prot, flags, this->fd, 0);
+
+    if (this->_data == MAP_FAILED) {
+        std::string msg {
+            "Shared memory: error mapping memory object " + this->_name +
+            " of size " + std::to_string(this->_size) + " bytes"
+        };
+
+        switch (errno) {
+            case EACCES:
+            case EBADF:
+                msg.append(": permissions/file error");
+            break;
+            case EAGAIN:
+                msg.append(": locking error");
+            break;
+            case EINVAL:
+                // Size > 0 is ensured by the header
+                msg.append(": too large");
+            break;
+            case ENODEV:
+                msg.append(": filesystem does not support mamory mapping");
+            break;
+            case ENOMEM:
+                msg.append(": no memory available or too many mappings");
+            break;
+            case EPERM:
+                msg.append(": file sealed or execution denied");
+            break;
+            default:
+                msg.append(" error code " + std::to_string(errno));
+            break;
+        }
+
+        throw MemoryError(msg);
+    }
+
+    // With MAP_POPULATE, the mapping was prefaulted inside mmap
+    if (this->_opts.populate)
+        this->_prefault_time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start
+        );
+
+    if (this->_huge_pages == HugePages::Transparent) {
+#ifdef MADV_HUGEPAGE
+        if (madvise(this->_data, this->_size, MADV_HUGEPAGE) == -1)
+            this->_huge_pages = HugePages::None;
+#else
+        this->_huge_pages = HugePages::None;
+#endif
+    }
+}
+
+inline void _SharedMemoryObject::map_mirrored() {
+    const auto data_bytes {this->_size - this->_data_offset};
+
+    if (data_bytes % this->_data_offset != 0)
+        throw MemoryError(
+            "Shared memory: cannot mirror " + this->_name + ": data size " +
+            std::to_string(data_bytes) + " bytes is not a multiple of the page size"
+        );
+
+    const auto prot {this->is_writable() ? PROT_READ | PROT_WRITE : PROT_READ};
+
+    // Reserve address space for both copies, then map over it
+    const auto base {mmap(NULL, this->mapped_size(), PROT_NONE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)};
+
+    if (base == MAP_FAILED)
+        throw MemoryError("Shared memory: could not reserve address space for " + this->_name +
+            ": error code " + std::to_string(errno));
+
+    const auto mirror {static_cast<char*>(base) + this->_size};
+
+    if (mmap(base, this->_size, prot, MAP_SHARED | MAP_FIXED, this->fd, 0) == MAP_FAILED
+        || mmap(mirror, data_bytes, prot, MAP_SHARED | MAP_FIXED, this->fd,
+            static_cast<off_t>(this->_data_offset)) == MAP_FAILED)
+    {
+        const auto code {errno};
+        munmap(base, this->mapped_size());
+        throw MemoryError("Shared memory: error mirroring " + this->_name +
+            ": error code " + std::to_string(code));
+    }
+
+    this->_data = base;
+}
+
+inline void _SharedMemoryObject::prefault() {
+    if (this->_opts.pretouch_threads > 0) {
+        const size_t page {static_cast<size_t>(sysconf(_SC_PAGESIZE))};
+        const auto pages {(this->_size + page - 1) / page};
+        const auto nthreads {std::min<size_t>(this->_opts.pretouch_threads, pages)};
+        const auto base {static_cast<char*>(this->_data)};
+        const auto writable {this->is_writable()};
+
+        // Each thread touches a contiguous run of pages
+        const auto touch = [=](size_t first, size_t last) {
+            for (auto i {first}; i < last; i++) {
+                const auto p {base + i * page};
+                if (writable)
+                    // Take a write fault without changing the data
+                    __atomic_fetch_add(p, 0, __ATOMIC_RELAXED);
+                else
+                    static_cast<void>(*static_cast<volatile char*>(p));
+            }
+        };
+
+        std::vector<std::thread> threads;
+        const auto per_thread {(pages + nthreads - 1) / nthreads};
+        for (size_t t {1}; t < nthreads; t++)
+            threads.emplace_back(touch, t * per_thread, std::min(pages, (t + 1) * per_thread));
+        touch(0, std::min(pages, per_thread));
+        for (auto& t : threads)
+            t.join();
+    }
+
+    if (this->_opts.lock && mlock(this->_data, this->_size) == -1) {
+        std::string msg {
+            "Shared memory: could not lock memory object " + this->_name +
+            " of size " + std::to_string(this->_size) + " bytes"
         };
 
         switch (errno) {
-            case EFBIG:
-                msg.append(": larger than maximum file size");
+            case ENOMEM:
+                msg.append(": exceeds RLIMIT_MEMLOCK");
             break;
             case EPERM:
                 msg.append(": permission denied");
             break;
-            case EINTR:
-                msg.append(": interrupted by signal");
+            case EAGAIN:
+                msg.append(": could not lock some pages");
             break;
-            case EBADF:
-            case EINVAL:
-                msg.append(": internal error");
+            default:
+                msg.append(" error code " + std::to_string(errno));
+            break;
+        }
+
+        throw MemoryError(msg);
+    }
+}
+
+inline void _SharedMemoryObject::flush(const void* begin, const void* end, Flush mode) {
+    static const auto page {static_cast<uintptr_t>(sysconf(_SC_PAGESIZE))};
+    const auto base {reinterpret_cast<uintptr_t>(this->_data)};
+
+    // msync needs a page-aligned start; the mapping itself is page-aligned
+    const auto first {std::max(reinterpret_cast<uintptr_t>(begin), base) / page * page};
+    const auto last {std::min(reinterpret_cast<uintptr_t>(end), base + this->_size)};
+
+    if (last <= first)
+        return;
+
+    const auto err {msync(reinterpret_cast<void*>(first), last - first,
+        mode == Flush::Sync ? MS_SYNC : MS_ASYNC)};
+
+    if (err == -1) {
+        std::string msg {"Shared memory: error flushing " + this->_name};
+
+        switch (errno) {
+            case EIO:
+                msg.append(": I/O error");
+            break;
+            case ENOMEM:
+                msg.append(": range not mapped");
             break;
             default:
-                msg.append(": error code " + std::to_string(errno));
+                msg.append(" error code " + std::to_string(errno));
+            break;
+        }
+
+        throw MemoryError(msg);
+    }
+}
+
+inline void _SharedMemoryObject::start_flusher() {
+    this->_flusher = std::thread([this]{
+        const auto begin {static_cast<const char*>(this->_data)};
+        std::unique_lock<std::mutex> lock {this->_flusher_mutex};
+
+        while (!this->_flusher_cv.wait_for(lock, this->_opts.flush_interval,
+            [this]{ return this->_flusher_stop; }))
+        {
+            try {
+                this->flush(begin, begin + this->_size, Flush::Async);
+            }
+            catch (const MemoryError& e) {
+                std::cerr << e.what() << '\n';
+            }
+        }
+    });
+}
+
+inline void _SharedMemoryObject::stop_flusher() {
+    if (!this->_flusher.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock {this->_flusher_mutex};
+        this->_flusher_stop = true;
+    }
+    this->_flusher_cv.notify_one();
+    this->_flusher.join();
+}
+
+inline void _SharedMemoryObject::unmap() {
+    if (this->_data != nullptr && this->_data != MAP_FAILED) {
+        const auto err {this->_sysv_id != -1
+            ? shmdt(this->_data)
+            : munmap(this->_data, this->mapped_size())};
+
+        if (err == -1) {
+            std::string msg {
+                "Shared memory: error unmapping object " + this->_name
+            };
+
+            switch (errno) {
+                case EINVAL:
+                    msg.append(": internal error");
+                break;
+                default:
+                    msg.append(" error code " + std::to_string(errno));
+                break;
+            }
+
+            msg.push_back('\n');
+            std::cerr << msg;
+        }
+    }
+
+    // Never unmap twice: the address may have been reused since
+    this->_data = nullptr;
+}
+
+
+// class SpscRing
+
+template<class Tp, size_t N>
+bool SpscRing<Tp, N>::try_push(const Tp& value) noexcept {
+    auto& l {this->layout()};
+    const auto w {l.write_idx.load(std::memory_order_relaxed)};
+
+    if (w - l.read_idx_cache == N) {
+        // Looks full: refresh the cached read cursor
+        l.read_idx_cache = l.read_idx.load(std::memory_order_acquire);
+        if (w - l.read_idx_cache == N)
+            return false;
+    }
+
+    l.slots[w & mask] = value;
+    l.write_idx.store(w + 1, std::memory_order_release);
+    return true;
+}
+
+template<class Tp, size_t N>
+bool SpscRing<Tp, N>::try_pop(Tp& value) noexcept {
+    const auto p {this->front()};
+    if (p == nullptr)
+        return false;
+
+    value = *p;
+    this->pop();
+    return true;
+}
+
+template<class Tp, size_t N>
+const Tp* SpscRing<Tp, N>::front() noexcept {
+    auto& l {this->layout()};
+    const auto r {l.read_idx.load(std::memory_order_relaxed)};
+
+    if (r == l.write_idx_cache) {
+        // Looks empty: refresh the cached write cursor
+        l.write_idx_cache = l.write_idx.load(std::memory_order_acquire);
+        if (r == l.write_idx_cache)
+            return nullptr;
+    }
+
+    return &l.slots[r & mask];
+}
+
+template<class Tp, size_t N>
+void SpscRing<Tp, N>::pop() noexcept {
+    auto& l {this->layout()};
+    const auto r {l.read_idx.load(std::memory_order_relaxed)};
+    l.read_idx.store(r + 1, std::memory_order_release);
+}
+
+// class MpmcQueue
+
+template<class Tp, size_t N>
+bool MpmcQueue<Tp, N>::try_push(const Tp& value) noexcept {
+    auto& l {this->layout()};
+    auto pos {l.enqueue_pos.load(std::memory_order_relaxed)};
+    _Slot* slot;
+
+    while (true) {
+        slot = &l.slots[pos & mask];
+        const size_t seq {slot->seq.load(std::memory_order_acquire) + (pos & mask)};
+        const auto dif {static_cast<std::ptrdiff_t>(seq - pos)};
+
+        if (dif == 0) {
+            // Slot is free for this ticket; try to claim it
+            if (l.enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (dif < 0) {
+            // Slot still holds the element from the previous lap
+            return false;
+        }
+        else {
+            // Another producer claimed this ticket
+            pos = l.enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->value = value;
+    slot->seq.store(pos + 1 - (pos & mask), std::memory_order_release);
+    return true;
+}
+
+template<class Tp, size_t N>
+bool MpmcQueue<Tp, N>::try_pop(Tp& value) noexcept {
+    auto& l {this->layout()};
+    auto pos {l.dequeue_pos.load(std::memory_order_relaxed)};
+    _Slot* slot;
+
+    while (true) {
+        slot = &l.slots[pos & mask];
+        const size_t seq {slot->seq.load(std::memory_order_acquire) + (pos & mask)};
+        const auto dif {static_cast<std::ptrdiff_t>(seq - (pos + 1))};
+
+        if (dif == 0) {
+            // Slot is full for this ticket; try to claim it
+            if (l.dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (dif < 0) {
+            // Slot has not been written for this lap yet
+            return false;
+        }
+        else {
+            // Another consumer claimed this ticket
+            pos = l.dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    value = slot->value;
+    slot->seq.store(pos + N - (pos & mask), std::memory_order_release);
+    return true;
+}
+
+// class SeqObject
+
+template<class Tp>
+void SeqObject<Tp>::store(const Tp& value) noexcept {
+    auto& l {this->layout()};
+    auto seq {l.seq.load(std::memory_order_relaxed)};
+
+    // Claim the lock by making the sequence odd
+    while (true) {
+        if ((seq & 1) == 0
+            && l.seq.compare_exchange_weak(seq, seq + 1, std::memory_order_relaxed))
             break;
+
+        seq = l.seq.load(std::memory_order_relaxed);
+    }
+
+    // Order the odd sequence before the payload writes
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&l.value, &value, sizeof(Tp));
+    l.seq.store(seq + 2, std::memory_order_release);
+}
+
+template<class Tp>
+Tp SeqObject<Tp>::load() const noexcept {
+    Tp value;
+    while (!this->try_load(value)) {}
+    return value;
+}
+
+template<class Tp>
+bool SeqObject<Tp>::try_load(Tp& value) const noexcept {
+    const auto& l {this->layout()};
+    const auto before {l.seq.load(std::memory_order_acquire)};
+
+    if (before & 1)
+        return false;
+
+    std::memcpy(&value, &l.value, sizeof(Tp));
+    // Order the payload reads before re-checking the sequence
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return l.seq.load(std::memory_order_relaxed) == before;
+}
+
+// class LatestValue
+
+template<class Tp>
+void LatestValue<Tp>::publish() noexcept {
+    auto& l {this->layout()};
+    const auto old {l.state.exchange((l.back_idx ^ 1) | fresh_bit, std::memory_order_acq_rel)};
+    l.back_idx = (old & index_mask) ^ 1;
+}
+
+template<class Tp>
+void LatestValue<Tp>::update() noexcept {
+    auto& l {this->layout()};
+
+    if (l.state.load(std::memory_order_relaxed) & fresh_bit) {
+        // Hand our copy back as the (stale) middle, and take the fresh one
+        const auto front {l.front_idx ^ 2};
+        const auto old {l.state.exchange(front ^ 1, std::memory_order_acq_rel)};
+        l.front_idx = ((old & index_mask) ^ 1) ^ 2;
+    }
+}
+
+// class ChunkPool
+
+template<size_t ChunkSize, size_t Chunks, size_t Depth>
+bool ChunkPool<ChunkSize, Chunks, Depth>::try_loan(ChunkLoan& loan) noexcept {
+    auto& l {this->layout()};
+
+    for (size_t i {0}; i < Chunks; i++) {
+        const auto c {(this->_next + i) % Chunks};
+        uint32_t free {0};
+
+        // Acquire: the last reader's accesses happen before our writes
+        if (l.refs[c].load(std::memory_order_relaxed) == 0
+            && l.refs[c].compare_exchange_strong(free, 1, std::memory_order_acquire))
+        {
+            this->_next = c + 1;
+            loan = ChunkLoan(this->_obj, l.refs[c], l.chunks[c], c * stride, ChunkSize);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+template<size_t ChunkSize, size_t Chunks, size_t Depth>
+void ChunkPool<ChunkSize, Chunks, Depth>::publish(ChunkLoan&& loan, size_t length) {
+    // Publishing takes over the loan's reference, which must be to our chunk
+    if (!loan || loan._obj != this->_obj)
+        throw std::invalid_argument("Shared memory: tried to publish a chunk not loaned from " +
+            this->_obj->name());
+
+    if (length > ChunkSize)
+        throw std::length_error(
+            "Shared memory: tried to publish " + std::to_string(length) +
+            " bytes, chunk size = " + std::to_string(ChunkSize)
+        );
+
+    auto& l {this->layout()};
+    const auto s {l.published.load(std::memory_order_relaxed)};
+    auto& slot {l.slots[s % Depth]};
+
+    const auto old_seq {slot.seq.load(std::memory_order_relaxed)};
+    const auto old_offset {slot.offset.load(std::memory_order_relaxed)};
+
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.offset.store(loan._offset, std::memory_order_relaxed);
+    slot.length.store(length, std::memory_order_relaxed);
+    slot.seq.store(s + 1, std::memory_order_release);
+    l.published.store(s + 1, std::memory_order_release);
+
+    // The loan's reference now belongs to the slot...
+    loan._refs = nullptr;
+    loan._obj.reset();
+
+    // ...and the overwritten message's reference is dropped
+    if (old_seq != 0)
+        l.refs[old_offset / stride].fetch_sub(1, std::memory_order_release);
+}
+
+template<size_t ChunkSize, size_t Chunks, size_t Depth>
+bool ChunkPool<ChunkSize, Chunks, Depth>::try_receive(ChunkView& view) noexcept {
+    auto& l {this->layout()};
+
+    while (true) {
+        const auto head {l.published.load(std::memory_order_acquire)};
+
+        if (this->_cursor == head)
+            return false;
+
+        if (head - this->_cursor > Depth) {
+            // Lapped: skip to the oldest message still held
+            this->_missed += head - Depth - this->_cursor;
+            this->_cursor = head - Depth;
+        }
+
+        auto& slot {l.slots[this->_cursor % Depth]};
+        const auto seq {slot.seq.load(std::memory_order_acquire)};
+        const auto offset {slot.offset.load(std::memory_order_relaxed)};
+        const auto length {slot.length.load(std::memory_order_relaxed)};
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        const auto c {offset / stride};
+
+        if (seq == this->_cursor + 1 && slot.seq.load(std::memory_order_relaxed) == seq
+            && c < Chunks && length <= ChunkSize)
+        {
+            // Take a reference, unless the chunk has already been freed
+            auto& refs {l.refs[c]};
+            auto n {refs.load(std::memory_order_relaxed)};
+
+            while (n != 0 && !refs.compare_exchange_weak(n, n + 1,
+                std::memory_order_acquire, std::memory_order_relaxed))
+            {}
+
+            if (n != 0) {
+                // Still the same message, so the reference protects it
+                if (slot.seq.load(std::memory_order_acquire) == seq) {
+                    this->_cursor++;
+                    view = ChunkView(this->_obj, refs, l.chunks[c], offset, length);
+                    return true;
+                }
+
+                refs.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        // Overwritten while we looked: the message is lost
+        this->_missed++;
+        this->_cursor++;
+    }
+}
+
+// class MessageRing
+
+template<size_t N>
+unsigned char* MessageRing<N>::try_reserve(size_t length) {
+    if (length > this->max_message())
+        throw std::length_error(
+            "Shared memory: tried to reserve " + std::to_string(length) +
+            " bytes, maximum message = " + std::to_string(this->max_message())
+        );
+
+    auto& l {this->layout()};
+    const auto w {l.write_idx.load(std::memory_order_relaxed)};
+    const auto size {record_size(length)};
+
+    // Records never wrap: pad to the end of the ring if this one would
+    const auto to_end {N - (w & mask)};
+    const auto needed {size <= to_end ? size : to_end + size};
+
+    if (N - (w - l.read_idx_cache) < needed) {
+        // Looks full: refresh the cached read cursor
+        l.read_idx_cache = l.read_idx.load(std::memory_order_acquire);
+        if (N - (w - l.read_idx_cache) < needed)
+            return nullptr;
+    }
+
+    auto start {w};
+    if (size > to_end) {
+        const _Record pad {static_cast<uint32_t>(to_end - sizeof(_Record)), 1};
+        std::memcpy(&l.bytes[w & mask], &pad, sizeof(pad));
+        start += to_end;
+    }
+
+    // Published along with the record by commit
+    if (start != w)
+        l.write_idx.store(start, std::memory_order_release);
+
+    this->_reserved = length;
+    return &l.bytes[(start & mask) + sizeof(_Record)];
+}
+
+template<size_t N>
+void MessageRing<N>::commit(size_t length) noexcept {
+    auto& l {this->layout()};
+    const auto w {l.write_idx.load(std::memory_order_relaxed)};
+
+    const _Record header {static_cast<uint32_t>(length), 0};
+    std::memcpy(&l.bytes[w & mask], &header, sizeof(header));
+
+    l.write_idx.store(w + record_size(length), std::memory_order_release);
+    this->_reserved = 0;
+}
+
+template<size_t N>
+const unsigned char* MessageRing<N>::peek(size_t& length) noexcept {
+    auto& l {this->layout()};
+
+    while (true) {
+        const auto r {l.read_idx.load(std::memory_order_relaxed)};
+
+        if (r == l.write_idx_cache) {
+            // Looks empty: refresh the cached write cursor
+            l.write_idx_cache = l.write_idx.load(std::memory_order_acquire);
+            if (r == l.write_idx_cache)
+                return nullptr;
+        }
+
+        _Record header;
+        std::memcpy(&header, &l.bytes[r & mask], sizeof(header));
+        const auto size {record_size(header.length)};
+
+        if (header.padding) {
+            // Skip to the start of the ring
+            l.read_idx.store(r + size, std::memory_order_release);
+            continue;
         }
 
-        throw FileError(msg);
+        this->_peeked = size;
+        length = header.length;
+        return &l.bytes[(r & mask) + sizeof(_Record)];
+    }
+}
+
+template<size_t N>
+void MessageRing<N>::consume() noexcept {
+    auto& l {this->layout()};
+    const auto r {l.read_idx.load(std::memory_order_relaxed)};
+    l.read_idx.store(r + this->_peeked, std::memory_order_release);
+    this->_peeked = 0;
+}
+
+// struct _FutexLock
+
+void _FutexLock::lock() noexcept {
+    uint32_t c {0};
+    if (this->state.compare_exchange_strong(c, 1, std::memory_order_acquire))
+        return;
+
+    // Contended: mark that there are waiters, and sleep until it is free
+    if (c != 2)
+        c = this->state.exchange(2, std::memory_order_acquire);
+    while (c != 0) {
+        _futex_wait(this->state, 2, nullptr);
+        c = this->state.exchange(2, std::memory_order_acquire);
+    }
+}
+
+void _FutexLock::unlock() noexcept {
+    if (this->state.exchange(0, std::memory_order_release) == 2)
+        _futex_wake(this->state);
+}
+
+// struct _HeapControl
+
+/** @returns The index of the most significant set bit of @a n (non-zero). */
+inline unsigned _msb(uint64_t n) noexcept {
+    return 63 - static_cast<unsigned>(__builtin_clzll(n));
+}
+
+void _HeapControl::mapping(uint64_t size, unsigned& fl, unsigned& sl) noexcept {
+    if (size < (uint64_t(1) << fl_shift)) {
+        fl = 0;
+        sl = static_cast<unsigned>(size >> align_log2);
+    }
+    else {
+        const auto f {_msb(size)};
+        sl = static_cast<unsigned>(size >> (f - sl_log2)) ^ sl_count;
+        fl = f - fl_shift + 1;
+    }
+}
+
+void _HeapControl::insert(uint64_t off) noexcept {
+    auto b {this->block(off)};
+    unsigned fl, sl;
+    mapping(b->payload(), fl, sl);
+
+    b->next_free = this->heads[fl][sl];
+    b->prev_free = 0;
+    if (b->next_free != 0)
+        this->block(b->next_free)->prev_free = off;
+
+    this->heads[fl][sl] = off;
+    this->fl_bitmap |= uint64_t(1) << fl;
+    this->sl_bitmap[fl] |= 1u << sl;
+}
+
+void _HeapControl::remove(uint64_t off) noexcept {
+    auto b {this->block(off)};
+    unsigned fl, sl;
+    mapping(b->payload(), fl, sl);
+
+    if (b->next_free != 0)
+        this->block(b->next_free)->prev_free = b->prev_free;
+
+    if (b->prev_free != 0) {
+        this->block(b->prev_free)->next_free = b->next_free;
+    }
+    else {
+        this->heads[fl][sl] = b->next_free;
+        if (b->next_free == 0) {
+            this->sl_bitmap[fl] &= ~(1u << sl);
+            if (this->sl_bitmap[fl] == 0)
+                this->fl_bitmap &= ~(uint64_t(1) << fl);
+        }
     }
 }
 
-template<size_t Sz>
-void _SharedMemoryObject<Sz>::close() {
-    if (this->fd != -1) {
-        // Only close the file if it is open
-        const auto err {::close(this->fd)};
+void _HeapControl::init(size_t bytes) noexcept {
+    this->capacity = bytes;
 
-        if (err == -1) {
-            // error handling
-            std::string msg {
-                "Shared memory: error when closing file " + this->_name +
-                " with descriptor " + std::to_string(this->fd)
-            };
+    // One free block, then a zero-sized used block marking the end
+    const uint64_t first {_round_up(sizeof(_HeapControl), align)};
+    const uint64_t last {bytes / align * align - block_overhead};
 
-            switch (errno) {
-                case EBADF:
-                    msg.append(": internal error");
-                break;
-                case EINTR:
-                    msg.append(": interrupted by signal");
-                break;
-                default:
-                    msg.append(" error code " + std::to_string(errno));
-                break;
+    auto b {this->block(first)};
+    b->prev_phys = 0;
+    b->size = (last - first - block_overhead) | _Block::free_bit;
+
+    auto end {this->block(last)};
+    end->prev_phys = first;
+    end->size = _Block::prev_free_bit;
+
+    this->free_bytes = b->payload();
+    this->insert(first);
+}
+
+void* _HeapControl::allocate(size_t bytes) noexcept {
+    if (bytes > this->capacity)
+        return nullptr;
+
+    const uint64_t size {_round_up(std::max<size_t>(bytes, min_payload), align)};
+
+    // Round up to the next list, so that any block found there fits
+    auto search {size};
+    if (search >= (uint64_t(1) << fl_shift))
+        search += (uint64_t(1) << (_msb(search) - sl_log2)) - 1;
+
+    std::lock_guard<_FutexLock> guard {this->lock};
+
+    uint64_t off {0};
+    unsigned fl, sl;
+    mapping(search, fl, sl);
+
+    if (fl < fl_count) {
+        auto sl_map {this->sl_bitmap[fl] & (~0u << sl)};
+        if (sl_map == 0) {
+            const auto fl_map {this->fl_bitmap & (~uint64_t(0) << (fl + 1))};
+            if (fl_map != 0) {
+                fl = static_cast<unsigned>(__builtin_ctzll(fl_map));
+                sl_map = this->sl_bitmap[fl];
             }
+        }
 
-            msg.push_back('\n');
-            std::cerr << msg;
+        if (sl_map != 0) {
+            sl = static_cast<unsigned>(__builtin_ctz(sl_map));
+            off = this->heads[fl][sl];
         }
     }
 
-    this->fd = -1;
+    if (off == 0) {
+        // The first block in the list for this exact size may still fit
+        mapping(size, fl, sl);
+        if (fl >= fl_count)
+            return nullptr;
+
+        off = this->heads[fl][sl];
+        if (off == 0 || this->block(off)->payload() < size)
+            return nullptr;
+    }
+
+    auto b {this->block(off)};
+    this->remove(off);
+
+    const auto payload {b->payload()};
+
+    if (payload >= size + block_overhead + min_payload) {
+        // Split off the rest as a new free block
+        const auto rest_off {off + block_overhead + size};
+        auto rest {this->block(rest_off)};
+        rest->prev_phys = off;
+        rest->size = (payload - size - block_overhead) | _Block::free_bit;
+        this->block(this->next_phys(rest_off))->prev_phys = rest_off;
+
+        b->set_payload(size);
+        this->insert(rest_off);
+        this->free_bytes -= size + block_overhead;
+    }
+    else {
+        this->block(this->next_phys(off))->size &= ~uint64_t(_Block::prev_free_bit);
+        this->free_bytes -= payload;
+    }
+
+    b->size &= ~uint64_t(_Block::free_bit);
+    return reinterpret_cast<char*>(b) + block_overhead;
 }
 
-template<size_t Sz>
-void _SharedMemoryObject<Sz>::unlink() {
-    const auto err {shm_unlink(this->_name.c_str())};
+void _HeapControl::deallocate(void* p) noexcept {
+    if (p == nullptr)
+        return;
 
-    if (err == -1) {
-        std::string msg {
-            "Shared memory: error when unlinking shared memory " + this->_name
-        };
+    auto off {static_cast<uint64_t>(static_cast<char*>(p) - reinterpret_cast<char*>(this))
+        - block_overhead};
 
-        switch (errno) {
-            case EACCES:
-                msg.append(": permission denied");
-            break;
-            case EMFILE:
-            case ENFILE:
-            case ENAMETOOLONG:
-                msg.append(": file error");
-            break;
-            case ENOENT:
-                // Probably already unlinked by another destructor
-                return;
-            break;
-            default:
-                msg.append(" error code " + std::to_string(errno));
-            break;
+    std::lock_guard<_FutexLock> guard {this->lock};
+
+    auto b {this->block(off)};
+    this->free_bytes += b->payload();
+
+    // Merge with the free neighbours
+    if (b->size & _Block::prev_free_bit) {
+        const auto prev_off {b->prev_phys};
+        auto prev {this->block(prev_off)};
+        this->remove(prev_off);
+        prev->set_payload(prev->payload() + block_overhead + b->payload());
+        this->free_bytes += block_overhead;
+        off = prev_off;
+        b = prev;
+    }
+
+    const auto next_off {this->next_phys(off)};
+    auto next {this->block(next_off)};
+
+    if (next->size & _Block::free_bit) {
+        this->remove(next_off);
+        b->set_payload(b->payload() + block_overhead + next->payload());
+        this->free_bytes += block_overhead;
+    }
+
+    b->size |= _Block::free_bit;
+    const auto after {this->block(this->next_phys(off))};
+    after->prev_phys = off;
+    after->size |= _Block::prev_free_bit;
+
+    this->insert(off);
+}
+
+// class Heap
+
+Heap::Heap(const std::string& name, size_t bytes, Permissions perm, const Options& opts):
+_obj{_SharedMemoryObject::acquire(name, Heap::checked_size(bytes), perm, opts,
+    _layout_of<_HeapControl>())}
+{
+    this->init();
+}
+
+Heap::Heap(const std::string& name, Permissions perm, const Options& opts):
+_obj{_SharedMemoryObject::acquire(name, 0, perm, opts, _layout_of<_HeapControl>())}
+{
+    this->init();
+}
+
+size_t Heap::checked_size(size_t bytes) {
+    if (bytes < sizeof(_HeapControl) + 4 * _HeapControl::block_overhead)
+        throw std::invalid_argument(
+            "Heap: " + std::to_string(bytes) + " bytes is too small, need at least " +
+            std::to_string(sizeof(_HeapControl) + 4 * _HeapControl::block_overhead)
+        );
+    return bytes;
+}
+
+void Heap::init() {
+    auto& header {this->_obj->header()};
+
+    if (!this->_obj->is_writable()) {
+        header.wait_constructed();
+        return;
+    }
+
+    if (header.begin_construction()) {
+        this->control().init(this->_obj->size());
+        header.end_construction(true);
+    }
+}
+
+void* Heap::allocate(size_t bytes) {
+    this->_obj->check_writable("allocate");
+    const auto p {this->control().allocate(bytes)};
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+// class Pool
+
+template<class Tp, size_t N>
+bool Pool<Tp, N>::pop(uint32_t& index) noexcept {
+    auto& l {this->layout()};
+    auto head {l.head.load(std::memory_order_acquire)};
+
+    while (true) {
+        const auto first {static_cast<uint32_t>(head)};
+        if (first == end)
+            return false;
+
+        // May read a link that is being rewritten; the tag then fails the CAS
+        const auto next {l.links[first].load(std::memory_order_relaxed) ^ (first + 1)};
+        const auto tag {(head >> 32) + 1};
+
+        if (l.head.compare_exchange_weak(head, (tag << 32) | next,
+            std::memory_order_acquire, std::memory_order_acquire)) {
+            index = first;
+            return true;
         }
+    }
+}
 
-        msg.push_back('\n');
-        std::cerr << msg;
+template<class Tp, size_t N>
+void Pool<Tp, N>::push(uint32_t first, uint32_t last) noexcept {
+    auto& l {this->layout()};
+    auto head {l.head.load(std::memory_order_relaxed)};
+
+    while (true) {
+        this->link(last, static_cast<uint32_t>(head));
+        const auto tag {(head >> 32) + 1};
+
+        if (l.head.compare_exchange_weak(head, (tag << 32) | first,
+            std::memory_order_release, std::memory_order_relaxed))
+            return;
     }
 }
 
-template<size_t Sz>
-void _SharedMemoryObject<Sz>::map() {
-    const auto prot = [this]{
-        int p = PROT_READ;
-        if (this->is_writable())
-            p |= PROT_WRITE;
-        return p;
-    }();
-    const auto flags = this->is_writable() ? MAP_SHARED : MAP_PRIVATE;
+template<class Tp, size_t N>
+bool Pool<Tp, N>::try_allocate(uint32_t& index) noexcept {
+    if (this->_cache_size == 0)
+        return this->pop(index);
 
-    this->_data = mmap(NULL, Sz, prot, flags, this->fd, 0);
+    if (this->_cache.empty()) {
+        // Refill half the cache, keeping room for frees
+        uint32_t i;
+        while (this->_cache.size() < (this->_cache_size + 1) / 2 && this->pop(i))
+            this->_cache.push_back(i);
 
-    if (this->_data == MAP_FAILED) {
-        std::string msg {
-            "Shared memory: error mapping memory object " + this->_name +
-            " of size " + std::to_string(Sz) + " bytes"
-        };
+        if (this->_cache.empty())
+            return false;
+    }
 
-        switch (errno) {
-            case EACCES:
-            case EBADF:
-                msg.append(": permissions/file error");
-            break;
-            case EAGAIN:
-                msg.append(": locking error");
-            break;
-            case EINVAL:
-                // Size > 0 is asserted at compile-time
-                msg.append(": too large");
-            break;
-            case ENODEV:
-                msg.append(": filesystem does not support mamory mapping");
-            break;
-            case ENOMEM:
-                msg.append(": no memory available or too many mappings");
-            break;
-            case EPERM:
-                msg.append(": file sealed or execution denied");
-            break;
-            default:
-                msg.append(" error code " + std::to_string(errno));
-            break;
+    index = this->_cache.back();
+    this->_cache.pop_back();
+    return true;
+}
+
+template<class Tp, size_t N>
+void Pool<Tp, N>::deallocate(uint32_t index) noexcept {
+    if (this->_cache_size == 0) {
+        this->push(index, index);
+        return;
+    }
+
+    if (this->_cache.size() == this->_cache_size) {
+        // Return the older half, at the front, as one chain
+        const auto count {this->_cache.size() - this->_cache_size / 2};
+        for (size_t i {0}; i + 1 < count; i++)
+            this->link(this->_cache[i], this->_cache[i + 1]);
+        this->push(this->_cache[0], this->_cache[count - 1]);
+        this->_cache.erase(this->_cache.begin(), this->_cache.begin() + count);
+    }
+
+    this->_cache.push_back(index);
+}
+
+template<class Tp, size_t N>
+void Pool<Tp, N>::drain() noexcept {
+    if (this->_cache.empty())
+        return;
+
+    for (size_t i {0}; i + 1 < this->_cache.size(); i++)
+        this->link(this->_cache[i], this->_cache[i + 1]);
+    this->push(this->_cache.front(), this->_cache.back());
+    this->_cache.clear();
+}
+
+// class Segment
+
+/** @returns The 64-bit FNV-1a hash of @a s. */
+inline uint64_t _fnv1a(const std::string& s) noexcept {
+    uint64_t hash {14695981039346656037ull};
+    for (const auto c : s)
+        hash = _fnv_mix(hash, static_cast<unsigned char>(c));
+    return hash;
+}
+
+Segment::Segment(const std::string& name, size_t bytes, size_t objects, Permissions perm,
+    const Options& opts):
+_obj{_SharedMemoryObject::acquire(name, Segment::checked_size(bytes, objects), perm, opts,
+    _fnv_mix(_layout_of<_Directory>(), sizeof(_HeapControl)))}
+{
+    this->init(objects);
+}
+
+Segment::Segment(const std::string& name, Permissions perm, const Options& opts):
+_obj{_SharedMemoryObject::acquire(name, 0, perm, opts,
+    _fnv_mix(_layout_of<_Directory>(), sizeof(_HeapControl)))}
+{
+    this->init(0);
+}
+
+size_t Segment::checked_size(size_t bytes, size_t objects) {
+    if (objects == 0)
+        throw std::invalid_argument("Segment: cannot create a directory of 0 objects");
+
+    const auto needed {heap_offset + sizeof(_HeapControl)
+        + 4 * (_HeapControl::block_overhead + objects * sizeof(_Entry))};
+
+    if (bytes < needed)
+        throw std::invalid_argument(
+            "Segment: " + std::to_string(bytes) + " bytes is too small for " +
+            std::to_string(objects) + " objects, need at least " + std::to_string(needed)
+        );
+    return bytes;
+}
+
+void Segment::init(size_t objects) {
+    auto& header {this->_obj->header()};
+
+    // Attaching handles leave setting up to the creator
+    if (objects == 0 || !this->_obj->is_writable()) {
+        header.wait_constructed();
+        return;
+    }
+
+    if (!header.begin_construction())
+        return;
+
+    auto& heap {this->heap()};
+    heap.init(this->_obj->size() - heap_offset);
+
+    // A power of two with at least half the table empty, for short probes
+    size_t entries {2};
+    while (entries < 2 * objects)
+        entries *= 2;
+
+    const auto table {heap.allocate(entries * sizeof(_Entry))};
+    if (table == nullptr) {
+        header.end_construction(false);
+        throw std::invalid_argument("Segment: " + this->_obj->name() +
+            " is too small for a directory of " + std::to_string(objects) + " objects");
+    }
+    std::memset(table, 0, entries * sizeof(_Entry));
+
+    auto& dir {this->directory()};
+    dir.mask = entries - 1;
+    dir.entries = static_cast<_Entry*>(table);
+    header.end_construction(true);
+}
+
+void* Segment::lookup(const std::string& name, uint64_t type) const {
+    const auto& dir {this->directory()};
+    const auto hash {_fnv1a(name)};
+
+    for (auto i {hash & dir.mask}; ; i = (i + 1) & dir.mask) {
+        const auto& entry {dir.entries[i]};
+
+        // Entries are only ever added, so an empty one ends the probe
+        if (entry.ready.load(std::memory_order_acquire) == 0)
+            return nullptr;
+
+        if (entry.hash == hash && entry.name_size == name.size()
+            && name.compare(0, name.size(), entry.name.get(), entry.name_size) == 0) {
+            if (entry.type != type)
+                throw LayoutError("Segment: " + name + " in " + this->_obj->name() +
+                    " has a different type");
+            return entry.object.get();
         }
+    }
+}
 
-        throw MemoryError(msg);
+void Segment::insert(const std::string& name, uint64_t type, void* obj) {
+    auto& dir {this->directory()};
+    const auto count {dir.count.load(std::memory_order_relaxed)};
+
+    // Keep an empty entry to end every probe
+    if (count >= dir.mask)
+        throw std::length_error("Segment: directory of " + this->_obj->name() + " is full");
+
+    const auto copy {static_cast<char*>(this->allocate(name.size() + 1))};
+    std::memcpy(copy, name.c_str(), name.size() + 1);
+
+    const auto hash {_fnv1a(name)};
+    auto i {hash & dir.mask};
+    while (dir.entries[i].ready.load(std::memory_order_relaxed) != 0)
+        i = (i + 1) & dir.mask;
+
+    auto& entry {dir.entries[i]};
+    entry.name_size = static_cast<uint32_t>(name.size());
+    entry.hash = hash;
+    entry.type = type;
+    entry.name = copy;
+    entry.object = obj;
+    entry.ready.store(1, std::memory_order_release);
+
+    dir.count.store(count + 1, std::memory_order_release);
+}
+
+void* Segment::allocate(size_t bytes) {
+    this->_obj->check_writable("allocate");
+    const auto p {this->heap().allocate(bytes)};
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+// class HashMap
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+uint32_t HashMap<K, V, N, Hash, KeyEqual>::stable_version(const _Bucket& b) noexcept {
+    while (true) {
+        const auto version {b.version.load(std::memory_order_acquire)};
+        if ((version & 1) == 0)
+            return version;
+        std::this_thread::yield();
     }
 }
 
-template<size_t Sz>
-void _SharedMemoryObject<Sz>::unmap() {
-    if (this->_data != nullptr && this->_data != MAP_FAILED) {
-        const auto err {munmap(this->_data, Sz)};
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+auto HashMap<K, V, N, Hash, KeyEqual>::bucket(const K& key) const noexcept -> const _Bucket* {
+    const auto& l {this->layout()};
+    const auto start {home(key)};
 
-        if (err == -1) {
-            std::string msg {
-                "Shared memory: error unmapping object " + this->_name
-            };
+    for (size_t n {0}; n < N; n++) {
+        const auto& b {l.buckets[(start + n) & mask]};
 
-            switch (errno) {
-                case EINVAL:
-                    msg.append(": internal error");
-                break;
-                default:
-                    msg.append(" error code " + std::to_string(errno));
-                break;
-            }
+        // Keys are never removed, so an empty bucket ends the probe
+        if (stable_version(b) == 0)
+            return nullptr;
+        if (KeyEqual()(b.key, key))
+            return &b;
+    }
 
-            msg.push_back('\n');
-            std::cerr << msg;
+    return nullptr;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+bool HashMap<K, V, N, Hash, KeyEqual>::insert(const K& key, const V& value) {
+    this->_obj->check_writable("insert");
+    auto& l {this->layout()};
+    const auto start {home(key)};
+
+    for (size_t n {0}; n < N; n++) {
+        auto& b {l.buckets[(start + n) & mask]};
+        uint32_t version {0};
+
+        if (b.version.compare_exchange_strong(version, 1, std::memory_order_acquire)) {
+            std::memcpy(&b.key, &key, sizeof(K));
+            std::memcpy(&b.value, &value, sizeof(V));
+            b.version.store(2, std::memory_order_release);
+            l.count.fetch_add(1, std::memory_order_relaxed);
+            return true;
         }
+
+        // Taken, perhaps by another insert of the same key: wait for its key
+        stable_version(b);
+        if (KeyEqual()(b.key, key))
+            return false;
+    }
+
+    return false;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+bool HashMap<K, V, N, Hash, KeyEqual>::assign(const K& key, const V& value) {
+    this->_obj->check_writable("assign");
+    auto b {const_cast<_Bucket*>(this->bucket(key))};
+    if (b == nullptr)
+        return false;
+
+    // Claim the bucket by making its version odd
+    auto version {b->version.load(std::memory_order_relaxed)};
+    while (true) {
+        if ((version & 1) == 0
+            && b->version.compare_exchange_weak(version, version + 1, std::memory_order_relaxed))
+            break;
+
+        std::this_thread::yield();
+        version = b->version.load(std::memory_order_relaxed);
+    }
+
+    // Order the odd version before the value writes
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&b->value, &value, sizeof(V));
+    b->version.store(next_version(version), std::memory_order_release);
+    return true;
+}
+
+template<class K, class V, size_t N, class Hash, class KeyEqual>
+bool HashMap<K, V, N, Hash, KeyEqual>::find(const K& key, V& value) const noexcept {
+    const auto b {this->bucket(key)};
+    if (b == nullptr)
+        return false;
+
+    while (true) {
+        const auto before {stable_version(*b)};
+        std::memcpy(&value, &b->value, sizeof(V));
+        // Order the value reads before re-checking the version
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (b->version.load(std::memory_order_relaxed) == before)
+            return true;
     }
 }
 
+// class Mutex
+
+Mutex::Mutex(bool priority_inherit) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+
+    auto code {0};
+    if (priority_inherit)
+        code = pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+    if (code == 0)
+        code = pthread_mutex_init(&this->_mutex, &attr);
+
+    pthread_mutexattr_destroy(&attr);
+
+    if (code != 0)
+        throw LockError("Mutex: could not initialise: error code " + std::to_string(code));
+}
+
 
 // Other API functions
 
+void sendDescriptor(int socket, int fd) {
+    char byte {0};
+    iovec iov {&byte, 1};
+    char control[CMSG_SPACE(sizeof(int))] {};
+
+    msghdr msg {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    auto cmsg {CMSG_FIRSTHDR(&msg)};
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    ssize_t n;
+    do {
+        n = sendmsg(socket, &msg, 0);
+    } while (n == -1 && errno == EINTR);
+
+    if (n == -1)
+        throw FileError("Shared memory: could not send descriptor " + std::to_string(fd) +
+            ": error code " + std::to_string(errno));
+}
+
+int receiveDescriptor(int socket) {
+    char byte;
+    iovec iov {&byte, 1};
+    char control[CMSG_SPACE(sizeof(int))] {};
+
+    msghdr msg {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t n;
+    do {
+        n = recvmsg(socket, &msg, MSG_CMSG_CLOEXEC);
+    } while (n == -1 && errno == EINTR);
+
+    if (n == -1)
+        throw FileError("Shared memory: could not receive descriptor: error code " +
+            std::to_string(errno));
+    if (n == 0)
+        throw FileError("Shared memory: could not receive descriptor: socket closed");
+
+    const auto cmsg {CMSG_FIRSTHDR(&msg)};
+    if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+        throw FileError("Shared memory: could not receive descriptor: none sent");
+
+    int fd;
+    std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
+}
+
 bool exists(const std::string& name) {
     bool b {false};
 
@@ -0,0 +1,68 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+int main() {
+    shm::Options opts;
+    opts.backend = shm::Backend::Anonymous;
+
+    // Both handles are created before forking, and inherited by the child
+    shm::Array<shmTest::anon_type, shmTest::anon_size> arr(shmTest::anon_name,
+        shm::Permissions::ReadWrite, opts);
+    shm::SpscRing<shmTest::anon_type, shmTest::anon_ring_size> ring(shmTest::anon_name, opts);
+
+    if (shm::exists(shmTest::anon_name))
+        throw std::runtime_error("An anonymous mapping has a name");
+    if (arr.descriptor() != -1)
+        throw std::runtime_error("An anonymous mapping has a descriptor");
+
+    std::cout.flush();
+    const auto pid {fork()};
+
+    if (pid == 0) {
+        // Child: fill the array, then stream values through the ring
+        std::iota(arr.begin(), arr.end(), 1);
+        arr.notify();
+
+        for (shmTest::anon_type i {0}; i < shmTest::anon_count; i++) {
+            while (!ring.try_push(i))
+                std::this_thread::yield();
+        }
+
+        return 0;
+    }
+    else if (pid < 0) {
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+
+    while (arr[shmTest::anon_size - 1] == 0)
+        arr.wait_for_change();
+
+    for (size_t i {0}; i < shmTest::anon_size; i++) {
+        if (arr[i] != i + 1)
+            throw std::runtime_error("Array element " + std::to_string(i) + " incorrect");
+    }
+
+    shmTest::anon_type value;
+    for (shmTest::anon_type i {0}; i < shmTest::anon_count; i++) {
+        while (!ring.try_pop(value))
+            std::this_thread::yield();
+
+        if (value != i)
+            throw std::runtime_error("Ring value " + std::to_string(i) + " incorrect");
+    }
+
+    int status {0};
+    waitpid(pid, &status, 0);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw std::runtime_error("Child failed");
+
+    std::cout << "Anonymous mapping test passed\n";
+
+    return 0;
+}
@@ -7,24 +7,32 @@
 #include <thread>
 
 int main() {
+    // Created before forking, as the read-only receiver only attaches
+    shm::Array<shmTest::arr_type, shmTest::arr_size> writer(shmTest::arr_name);
+
     const auto pid {fork()};
 
     if (pid > 0) {
         // Parent (sender)
 
-        shm::Array<shmTest::arr_type, shmTest::arr_size> mem(shmTest::arr_name);
+        auto& mem = writer;
 
         std::cout << "Sender launched\n";
 
         for (auto i {0}; i < shmTest::arr_size; i++) {
             mem.at(i) = shmTest::arr_seq.at(i);
         }
+        mem.notify();
 
         std::cout << "Data sent\n";
 
-        waitpid(pid, nullptr, 0);
+        int status {0};
+        waitpid(pid, &status, 0);
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            throw std::runtime_error("Receiver failed");
 
-        // Check data was not changed by read-only receiver
+        // Check data was not changed by the read-only receiver
         if (mem[1] != shmTest::arr_seq[1])
             throw std::runtime_error("Array was changed by read-only mapping");
 
@@ -44,6 +52,8 @@ int main() {
 
             if (sum == shmTest::arr_sum)
                 break;
+
+            mem.wait_for_change();
         };
 
         std::cout << "Data received:\n";
@@ -51,11 +61,6 @@ int main() {
             std::cout << el << '\t';
         std::cout << std::endl;
 
-        // Test for read-only-ness
-        mem[1] = ~mem[1];
-        // Ensure enough time has passed for data carry-through
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
-
     }
     else {
         // Error
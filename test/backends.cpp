@@ -0,0 +1,73 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+template<class Storage>
+using TestArray = shm::Array<shmTest::backend_type, shmTest::backend_size, Storage>;
+
+template<class Storage>
+void testBackend(const std::string& label, const std::string& name) {
+    shm::Options open;
+    open.open_mode = shm::OpenMode::Open;
+
+    {
+        TestArray<Storage> writer(name);
+        std::iota(writer.begin(), writer.end(), 0);
+
+        std::cout.flush();
+        const auto pid {fork()};
+
+        if (pid == 0) {
+            // Child: attach by name, as an unrelated process would
+            TestArray<Storage> reader(name, shm::Permissions::ReadOnly, open);
+
+            for (size_t i {0}; i < shmTest::backend_size; i++) {
+                if (reader[i] != i)
+                    throw std::runtime_error(label + ": element " + std::to_string(i) + " incorrect");
+            }
+
+            exit(0);
+        }
+        else if (pid < 0) {
+            std::cerr << "Failed to fork\n";
+            exit(1);
+        }
+
+        int status {0};
+        waitpid(pid, &status, 0);
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            throw std::runtime_error(label + ": child failed");
+    }
+
+    // The owner removed it
+    try {
+        TestArray<Storage> reader(name, shm::Permissions::ReadOnly, open);
+        throw std::logic_error(label + ": not removed by its owner");
+    }
+    catch (const shm::FileError&) {}
+
+    std::cout << label << " backend test passed\n";
+}
+
+int main() {
+    shm_unlink(shmTest::backend_name.c_str());
+    unlink(shmTest::backend_file.c_str());
+
+    testBackend<shm::PosixShmBackend>("POSIX", shmTest::backend_name);
+    testBackend<shm::SysVBackend>("System V", shmTest::backend_name);
+    testBackend<shm::FileBackend>("File", shmTest::backend_file);
+
+    // The policy overrides the options
+    shm::Options opts;
+    opts.backend = shm::Backend::PosixShm;
+    TestArray<shm::AnonymousBackend> anon(shmTest::backend_name, shm::Permissions::ReadWrite, opts);
+
+    if (shm::exists(shmTest::backend_name))
+        throw std::runtime_error("Policy did not override the options");
+
+    return 0;
+}
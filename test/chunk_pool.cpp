@@ -0,0 +1,119 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using Pool = shm::ChunkPool<shmTest::chunk_size, shmTest::chunk_count>;
+
+size_t messageLength(uint64_t n) {
+    return shmTest::chunk_size - n % 100;
+}
+
+/** Checks that @a view holds message number @a n, as written by main. */
+void check(const shm::ChunkView& view, uint64_t n) {
+    if (view.size() != messageLength(n))
+        throw std::runtime_error("Message " + std::to_string(n) + " has the wrong length");
+
+    for (size_t i {sizeof(n)}; i < view.size(); i++) {
+        if (view.data()[i] != static_cast<unsigned char>(n + i))
+            throw std::runtime_error("Message " + std::to_string(n) + " corrupted at " + std::to_string(i));
+    }
+}
+
+int main() {
+    shm_unlink(shmTest::chunk_name.c_str());
+
+    Pool pool(shmTest::chunk_name);
+
+    std::cout.flush();
+    const auto pid {fork()};
+
+    if (pid == 0) {
+        // Child: publisher
+        for (uint64_t n {0}; n < shmTest::chunk_messages; n++) {
+            shm::ChunkLoan loan;
+            while (!pool.try_loan(loan))
+                std::this_thread::yield();
+
+            std::memcpy(loan.data(), &n, sizeof(n));
+            for (size_t i {sizeof(n)}; i < messageLength(n); i++)
+                loan.data()[i] = static_cast<unsigned char>(n + i);
+
+            pool.publish(std::move(loan), messageLength(n));
+
+            if (n % 16 == 0)
+                std::this_thread::yield();
+        }
+
+        return 0;
+    }
+    else if (pid < 0) {
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+
+    // Parent: subscriber. Holds on to the first message throughout, which
+    // must never be overwritten.
+    shm::ChunkView first;
+    uint64_t first_n {0};
+    uint64_t received {0};
+    uint64_t last {0};
+
+    while (received + pool.missed() < shmTest::chunk_messages) {
+        shm::ChunkView view;
+        if (!pool.try_receive(view)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        uint64_t n;
+        std::memcpy(&n, view.data(), sizeof(n));
+
+        if (received > 0 && n <= last)
+            throw std::runtime_error("Message " + std::to_string(n) + " out of order");
+        check(view, n);
+
+        last = n;
+        received++;
+
+        if (!first) {
+            first = std::move(view);
+            first_n = n;
+        }
+    }
+
+    check(first, first_n);
+
+    int status {0};
+    waitpid(pid, &status, 0);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw std::runtime_error("Publisher failed");
+
+    // Once released, every chunk not held by the ring is loanable again
+    first.release();
+
+    // An empty loan holds no chunk to publish
+    try {
+        shm::ChunkLoan empty;
+        pool.publish(std::move(empty), 0);
+        throw std::logic_error("Published an empty loan");
+    }
+    catch (const std::invalid_argument& e) {
+        std::cout << "Publish empty: " << e.what() << '\n';
+    }
+
+    std::vector<shm::ChunkLoan> loans(shmTest::chunk_count);
+    size_t loaned {0};
+    while (loaned < loans.size() && pool.try_loan(loans[loaned]))
+        loaned++;
+
+    if (loaned != shmTest::chunk_count - shmTest::chunk_count / 2)
+        throw std::runtime_error("Chunks leaked: only " + std::to_string(loaned) + " free");
+
+    std::cout << "Received " << received << " messages, missed " << pool.missed() << '\n';
+
+    return 0;
+}
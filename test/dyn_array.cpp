@@ -0,0 +1,71 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <unistd.h>
+#include <sys/wait.h>
+#include <thread>
+
+int main() {
+    // Created before forking, so the receiver can attach without a size
+    shm::DynArray<int> mem(shmTest::dyn_name, shmTest::dyn_size);
+
+    if (mem.size() != shmTest::dyn_size)
+        throw std::runtime_error("DynArray created with the wrong size");
+
+    std::cout.flush();
+    const auto pid {fork()};
+
+    if (pid > 0) {
+        // Parent (sender)
+
+        std::cout << "Sender launched\n";
+
+        for (size_t i {0}; i < mem.size(); i++)
+            mem.at(i) = static_cast<int>(i + 1);
+        mem.notify();
+
+        std::cout << "Data sent\n";
+
+        int status {0};
+        waitpid(pid, &status, 0);
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            throw std::runtime_error("Receiver attached with the wrong size or data");
+
+    }
+    else if (pid == 0) {
+        // Child (receiver)
+
+        std::cout << "Receiver launched\n";
+
+        shm::DynArray<int> other(shmTest::dyn_name, shm::Permissions::ReadOnly);
+
+        if (other.size() != shmTest::dyn_size)
+            throw std::runtime_error("Discovered the wrong size");
+
+        while (other[other.size() - 1] == 0)
+            other.wait_for_change();
+
+        for (size_t i {0}; i < other.size(); i++) {
+            if (other.at(i) != static_cast<int>(i + 1))
+                throw std::runtime_error("Received the wrong data");
+        }
+
+        std::cout << "Data received: " << other.size() << " elements\n";
+
+        // Attaching to a missing SMO must fail rather than create it
+        try {
+            shm::DynArray<int> missing(shm::formatName("ShmCpp_Test_Missing"));
+            throw std::logic_error("Attached to a missing SMO");
+        }
+        catch (const shm::FileError&) {}
+
+    }
+    else {
+        // Error
+
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+}
@@ -0,0 +1,98 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+void check(const shmTest::emplace_type& table) {
+    for (size_t i {0}; i < shmTest::emplace_type::size; i++) {
+        if (table.values[i] != shmTest::emplace_seed * i)
+            throw std::runtime_error("Table entry " + std::to_string(i) + " incorrect");
+    }
+}
+
+int main() {
+    shm_unlink(shmTest::emplace_name.c_str());
+    shm_unlink(shmTest::emplace_count_name.c_str());
+
+    shm::Object<shmTest::emplace_type> table(shmTest::emplace_name);
+    shm::Object<std::atomic<uint32_t>> constructions(shmTest::emplace_count_name);
+
+    if (table.is_constructed())
+        throw std::runtime_error("New table already constructed");
+
+    // A reader waits for the table, without constructing it. It reports
+    // when it has attached, so that it does so while the table exists.
+    int attached[2];
+    if (pipe(attached) == -1)
+        throw std::runtime_error("Could not create a pipe");
+
+    std::cout.flush();
+    const auto reader {fork()};
+
+    if (reader == 0) {
+        shm::Object<shmTest::emplace_type> ro(shmTest::emplace_name, shm::Permissions::ReadOnly);
+        if (write(attached[1], "", 1) != 1)
+            _exit(1);
+
+        ro.wait_constructed();
+        check(ro.get());
+
+        // Read-only handles cannot construct it
+        try {
+            ro.emplace(0, constructions.get());
+            _exit(1);
+        }
+        catch (const shm::FileError&) {}
+
+        _exit(0);
+    }
+    else if (reader < 0) {
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+
+    close(attached[1]);
+    char byte;
+    if (read(attached[0], &byte, 1) != 1)
+        throw std::runtime_error("Reader failed to attach");
+    close(attached[0]);
+
+    // Every writer races to construct it
+    std::vector<pid_t> pids;
+    for (size_t p {0}; p < shmTest::emplace_procs; p++) {
+        const auto pid {fork()};
+
+        if (pid == 0) {
+            check(table.emplace(shmTest::emplace_seed, constructions.get()));
+            _exit(0);
+        }
+        else if (pid < 0) {
+            std::cerr << "Failed to fork\n";
+            exit(1);
+        }
+
+        pids.push_back(pid);
+    }
+    pids.push_back(reader);
+
+    for (const auto pid : pids) {
+        int status {0};
+        waitpid(pid, &status, 0);
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            throw std::runtime_error("Child failed");
+    }
+
+    // Later callers get the existing table
+    check(table.emplace(0, constructions.get()));
+
+    if (constructions.get() != 1)
+        throw std::runtime_error("Table constructed " +
+            std::to_string(constructions.get().load()) + " times");
+
+    std::cout << "Emplace test passed\n";
+
+    return 0;
+}
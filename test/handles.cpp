@@ -0,0 +1,108 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <thread>
+#include <vector>
+
+using Arr = shm::Array<int, 4>;
+
+std::string nameOf(size_t i) {
+    return shmTest::handle_name + std::to_string(i);
+}
+
+// Handles can be returned from factories
+Arr makeArray(size_t i) {
+    Arr arr(nameOf(i));
+    arr[0] = static_cast<int>(i);
+    return arr;
+}
+
+int main() {
+    shm_unlink(shmTest::handle_name.c_str());
+    for (size_t i {0}; i < shmTest::handle_count; i++)
+        shm_unlink(nameOf(i).c_str());
+
+    // Opening the same SMO twice reuses the mapping
+    {
+        shm::Object<int> a(shmTest::handle_name);
+        shm::Object<int> b(shmTest::handle_name);
+
+        if (a.data() != b.data())
+            throw std::runtime_error("Second handle did not reuse the mapping");
+
+        // ... but not for different permissions
+        shm::Object<int> c(shmTest::handle_name, shm::Permissions::ReadOnly);
+
+        if (a.data() == c.data())
+            throw std::runtime_error("Read-only handle reused a writable mapping");
+
+        // ... nor for options affecting the mapping, which must take effect
+        shm::Options opts;
+        opts.populate = true;
+        shm::Object<int> d(shmTest::handle_name, shm::Permissions::ReadWrite, opts);
+
+        if (a.data() == d.data())
+            throw std::runtime_error("Handle with other options reused the mapping");
+
+        a = 42;
+        if (c.get() != 42 || d.get() != 42)
+            throw std::runtime_error("Other handles did not see the data");
+    }
+
+    if (shm::exists(shmTest::handle_name))
+        throw std::runtime_error("SMO not removed with its last handle");
+
+    std::cout << "Mapping reuse: ok\n";
+
+    // A mapping torn down in one thread never removes the SMO after another
+    // thread has opened it again
+    {
+        std::atomic<bool> failed {false};
+        const auto churn = [&failed]() {
+            for (size_t i {0}; i < shmTest::handle_rounds; i++) {
+                shm::Object<int> o(shmTest::handle_name);
+                if (!shm::exists(shmTest::handle_name))
+                    failed = true;
+            }
+        };
+
+        std::thread t1 {churn};
+        std::thread t2 {churn};
+        t1.join();
+        t2.join();
+
+        if (failed)
+            throw std::runtime_error("SMO removed while a handle was open");
+    }
+
+    std::cout << "Concurrent teardown: ok\n";
+
+    // Handles can be stored in containers, which move them as they grow
+    {
+        std::vector<Arr> arrays;
+        for (size_t i {0}; i < shmTest::handle_count; i++)
+            arrays.push_back(makeArray(i));
+
+        for (size_t i {0}; i < shmTest::handle_count; i++) {
+            if (arrays[i][0] != static_cast<int>(i))
+                throw std::runtime_error("Moved handle lost its data");
+            if (!shm::exists(nameOf(i)))
+                throw std::runtime_error("Moving a handle removed its SMO");
+        }
+
+        // Move assignment releases the target's previous mapping
+        arrays[0] = std::move(arrays[1]);
+        if (arrays[0][0] != 1)
+            throw std::runtime_error("Move assignment did not take the mapping");
+        if (shm::exists(nameOf(0)))
+            throw std::runtime_error("Move assignment did not release the old mapping");
+    }
+
+    for (size_t i {0}; i < shmTest::handle_count; i++) {
+        if (shm::exists(nameOf(i)))
+            throw std::runtime_error("SMO not removed after its handles were destroyed");
+    }
+
+    std::cout << "Move semantics: ok\n";
+}
@@ -0,0 +1,102 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using Map = shm::HashMap<uint64_t, shmTest::map_value, shmTest::map_size>;
+
+int main() {
+    shm_unlink(shmTest::map_name.c_str());
+
+    Map map(shmTest::map_name);
+
+    std::cout.flush();
+    std::vector<pid_t> children;
+
+    for (size_t c {0}; c < shmTest::map_children; c++) {
+        const auto pid {fork()};
+
+        if (pid == 0) {
+            // Child: every child inserts every key; only one insert of each wins
+            Map m(shmTest::map_name);
+            uint64_t won {0};
+
+            for (uint64_t k {0}; k < shmTest::map_keys; k++) {
+                if (m.insert(k * 7919, shmTest::map_value{k * 7919, c, 0.0}))
+                    won++;
+            }
+
+            // Readers see consistent values while they are reassigned
+            const Map reader(shmTest::map_name, shm::Permissions::ReadOnly);
+
+            for (uint64_t round {1}; round <= 20; round++) {
+                for (uint64_t k {c}; k < shmTest::map_keys; k += shmTest::map_children)
+                    m.assign(k * 7919, shmTest::map_value{k * 7919, round, round * 0.5});
+
+                for (uint64_t k {0}; k < shmTest::map_keys; k++) {
+                    shmTest::map_value v;
+                    if (!reader.find(k * 7919, v))
+                        throw std::runtime_error("Key " + std::to_string(k) + " missing");
+                    if (v.key != k * 7919 || (v.version > 0 && v.price != v.version * 0.5))
+                        throw std::runtime_error("Torn value for key " + std::to_string(k));
+                }
+            }
+
+            std::cout << "Child " << c << " inserted " << won << " keys\n";
+            std::cout.flush();
+            _exit(0);
+        }
+        else if (pid < 0) {
+            std::cerr << "Failed to fork\n";
+            exit(1);
+        }
+
+        children.push_back(pid);
+    }
+
+    for (const auto pid : children) {
+        int status {0};
+        waitpid(pid, &status, 0);
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            throw std::runtime_error("Child failed");
+    }
+
+    if (map.size() != shmTest::map_keys)
+        throw std::runtime_error("Map has " + std::to_string(map.size()) + " keys");
+
+    for (uint64_t k {0}; k < shmTest::map_keys; k++) {
+        shmTest::map_value v;
+        if (!map.find(k * 7919, v) || v.version != 20)
+            throw std::runtime_error("Key " + std::to_string(k) + " incorrect");
+    }
+
+    if (map.contains(1) || map.assign(1, shmTest::map_value{}))
+        throw std::runtime_error("Found a missing key");
+
+    // Read-only handles cannot write
+    Map reader(shmTest::map_name, shm::Permissions::ReadOnly);
+    try {
+        reader.insert(1, shmTest::map_value{});
+        throw std::logic_error("Inserted into a read-only map");
+    }
+    catch (const shm::FileError& e) {
+        std::cout << "Read-only insert: " << e.what() << '\n';
+    }
+
+    // Fill the map
+    uint64_t k {shmTest::map_keys * 7919};
+    while (map.insert(++k, shmTest::map_value{k, 0, 0.0})) {}
+
+    if (map.size() != shmTest::map_size)
+        throw std::runtime_error("Map full at " + std::to_string(map.size()) + " keys");
+    if (!map.contains(k - 1) || map.contains(k))
+        throw std::runtime_error("Full map lookups incorrect");
+
+    std::cout << "HashMap test passed\n";
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <random>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using Vector = std::vector<uint64_t, shm::Allocator<uint64_t>>;
+using String = std::basic_string<char, std::char_traits<char>, shm::Allocator<char>>;
+
+struct Root {
+    Vector values;
+    String text;
+    shm::offset_ptr<Root> self;
+
+    explicit Root(shm::Heap& heap):
+    values{heap.allocator<uint64_t>()},
+    text{heap.allocator<char>()},
+    self{this}
+    {}
+};
+
+int main() {
+    shm_unlink(shmTest::heap_name.c_str());
+
+    shm::Heap heap(shmTest::heap_name, shmTest::heap_size);
+    const auto initial_free {heap.free_bytes()};
+
+    auto root {heap.construct<Root>(heap)};
+    const auto root_offset {heap.offset_of(root)};
+
+    for (uint64_t i {0}; i < shmTest::heap_elements; i++)
+        root->values.push_back(i);
+    root->text = "A string long enough not to fit in the small string buffer";
+
+    // A second mapping, at another address, sees the same structures
+    shm::Heap view(shmTest::heap_name, shm::Permissions::ReadOnly);
+    const auto seen {view.at<Root>(root_offset)};
+
+    if (static_cast<const void*>(seen) == static_cast<const void*>(root))
+        throw std::runtime_error("Both mappings are at the same address");
+    if (seen->self.get() != seen)
+        throw std::runtime_error("offset_ptr not relative to its own mapping");
+    if (seen->values.size() != shmTest::heap_elements || seen->values.back() != shmTest::heap_elements - 1)
+        throw std::runtime_error("Vector incorrect in the second mapping");
+    if (std::string(seen->text.begin(), seen->text.end()) != std::string(root->text.begin(), root->text.end()))
+        throw std::runtime_error("String incorrect in the second mapping");
+
+    // Read-only handles cannot allocate
+    try {
+        view.allocate(1);
+        throw std::logic_error("Allocated from a read-only heap");
+    }
+    catch (const shm::FileError& e) {
+        std::cout << "Read-only allocate: " << e.what() << '\n';
+    }
+
+    std::cout.flush();
+    const auto pid {fork()};
+
+    if (pid == 0) {
+        // Child: grow the containers, allocating from the same heap
+        shm::Heap child(shmTest::heap_name);
+        auto r {child.at<Root>(root_offset)};
+
+        for (uint64_t i {shmTest::heap_elements}; i < 2 * shmTest::heap_elements; i++)
+            r->values.push_back(i);
+        r->text += " - appended by the child";
+
+        return 0;
+    }
+    else if (pid < 0) {
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+
+    int status {0};
+    waitpid(pid, &status, 0);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw std::runtime_error("Child failed");
+
+    for (uint64_t i {0}; i < 2 * shmTest::heap_elements; i++) {
+        if (root->values[i] != i)
+            throw std::runtime_error("Vector element " + std::to_string(i) + " incorrect");
+    }
+    if (root->text.size() < 24 || root->text.compare(root->text.size() - 24, 24, " - appended by the child") != 0)
+        throw std::runtime_error("String not appended to");
+
+    heap.destroy(root);
+    if (heap.free_bytes() != initial_free)
+        throw std::runtime_error("Heap not whole after freeing the containers");
+
+    // Random allocations and frees, of many sizes, all coalesce back
+    std::mt19937 rng {42};
+    std::vector<void*> blocks;
+
+    for (size_t round {0}; round < shmTest::heap_rounds; round++) {
+        if (!blocks.empty() && (rng() % 2 == 0 || heap.free_bytes() < 64 * 1024)) {
+            const auto i {rng() % blocks.size()};
+            heap.deallocate(blocks[i]);
+            blocks[i] = blocks.back();
+            blocks.pop_back();
+        }
+        else {
+            const size_t bytes {1 + rng() % (1u << (rng() % 14))};
+            const auto p {heap.allocate(bytes)};
+
+            if (reinterpret_cast<uintptr_t>(p) % 16 != 0 || !heap.owns(p))
+                throw std::runtime_error("Bad allocation of " + std::to_string(bytes) + " bytes");
+            std::memset(p, 0xAB, bytes);
+            blocks.push_back(p);
+        }
+    }
+
+    for (const auto p : blocks)
+        heap.deallocate(p);
+
+    if (heap.free_bytes() != initial_free)
+        throw std::runtime_error("Heap fragmented after random use");
+
+    // The whole free block can be allocated again, and no more
+    heap.deallocate(heap.allocate(initial_free));
+
+    try {
+        heap.allocate(initial_free + 1);
+        throw std::logic_error("Allocated more than the free space");
+    }
+    catch (const std::bad_alloc&) {
+        std::cout << "Heap full: bad_alloc\n";
+    }
+
+    std::cout << "Heap test passed\n";
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <unistd.h>
+#include <sys/wait.h>
+#include <thread>
+
+int main() {
+    // Start from zero values, whatever a previous run left behind
+    shm_unlink(shmTest::latest_name.c_str());
+
+    const auto pid {fork()};
+
+    if (pid > 0) {
+        // Parent (writer)
+
+        shm::LatestValue<shmTest::latest_type> mem(shmTest::latest_name);
+
+        std::cout << "Writer launched\n";
+
+        for (uint64_t i {1}; i <= shmTest::latest_count; i++) {
+            // Write in place, then publish
+            for (auto& v : mem.back().values)
+                v = i;
+            mem.publish();
+        }
+
+        std::cout << "Data sent\n";
+
+        int status {0};
+        waitpid(pid, &status, 0);
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            throw std::runtime_error("Reader observed a torn or stale value");
+
+    }
+    else if (pid == 0) {
+        // Child (reader)
+
+        std::cout << "Receiver launched\n";
+
+        shm::LatestValue<shmTest::latest_type> mem(shmTest::latest_name);
+
+        uint64_t last {0};
+        size_t updates {0};
+
+        while (last != shmTest::latest_count) {
+            if (!mem.has_update()) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            const auto& v {mem.get()};
+            updates++;
+
+            for (const auto& x : v.values) {
+                if (x != v.values[0])
+                    throw std::runtime_error("Torn read");
+            }
+            if (v.values[0] < last)
+                throw std::runtime_error("Value went backwards");
+
+            last = v.values[0];
+        }
+
+        std::cout << "Data received after " << updates << " updates\n";
+
+    }
+    else {
+        // Error
+
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+}
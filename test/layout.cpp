@@ -0,0 +1,71 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+shm::Options checked(uint32_t version = shmTest::layout_version) {
+    shm::Options opts;
+    opts.check_layout = true;
+    opts.layout_version = version;
+    return opts;
+}
+
+template<class Tp>
+void expectMismatch(const std::string& what, const shm::Options& opts) {
+    try {
+        shm::Object<Tp> obj(shmTest::layout_name, shm::Permissions::ReadWrite, opts);
+        throw std::logic_error("Layout check missed " + what);
+    }
+    catch (const shm::LayoutError& e) {
+        std::cout << what << ": " << e.what() << '\n';
+    }
+}
+
+int main() {
+    shm_unlink(shmTest::layout_name.c_str());
+
+    // The first checked writer stamps the layout
+    shm::Object<uint64_t> writer(shmTest::layout_name, shm::Permissions::ReadWrite, checked());
+    writer = 42;
+
+    expectMismatch<uint32_t>("Smaller type", checked());
+    expectMismatch<uint64_t>("Different version", checked(shmTest::layout_version + 1));
+
+    // Unchecked handles are unaffected
+    shm::Object<uint32_t> unchecked(shmTest::layout_name);
+
+    std::cout.flush();
+    const auto pid {fork()};
+
+    if (pid == 0) {
+        // Child: a matching reader attaches, a mismatched one does not
+        shm::Object<uint64_t> reader(shmTest::layout_name, shm::Permissions::ReadOnly, checked());
+        if (reader.get() != 42)
+            throw std::runtime_error("Reader did not see the data");
+
+        try {
+            shm::Object<uint16_t[2]> mismatched(shmTest::layout_name,
+                shm::Permissions::ReadOnly, checked());
+            throw std::logic_error("Layout check missed a different type in another process");
+        }
+        catch (const shm::LayoutError&) {}
+
+        return 0;
+    }
+    else if (pid < 0) {
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+
+    int status {0};
+    waitpid(pid, &status, 0);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw std::runtime_error("Child failed");
+
+    std::cout << "Layout test passed\n";
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <memory>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using Obj = shm::Object<int>;
+
+shm::Options withLifetime(shm::Lifetime lifetime) {
+    shm::Options opts;
+    opts.lifetime = lifetime;
+    return opts;
+}
+
+void expectExists(bool expected, const char* when) {
+    if (shm::exists(shmTest::lifetime_name) != expected)
+        throw std::runtime_error(std::string("Wrong SMO existence ") + when);
+}
+
+// Destroys the copy of @a handle inherited by a forked child, as the child's
+// normal exit would, while the parent stays attached
+void destroyInChild(std::unique_ptr<Obj>& handle) {
+    std::cout.flush();
+    const auto pid {fork()};
+
+    if (pid == 0) {
+        handle.reset();
+        _exit(0);
+    }
+    else if (pid < 0) {
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+
+    int status {0};
+    waitpid(pid, &status, 0);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw std::runtime_error("Child failed");
+}
+
+int main() {
+    shm_unlink(shmTest::lifetime_name.c_str());
+
+    // Owner: only the creator removes the SMO
+    {
+        const auto opts {withLifetime(shm::Lifetime::Owner)};
+        std::unique_ptr<Obj> owner {new Obj(shmTest::lifetime_name, shm::Permissions::ReadWrite, opts)};
+
+        destroyInChild(owner);
+        expectExists(true, "after a forked child's copy of the owner detached");
+
+        std::unique_ptr<Obj> other {new Obj(shmTest::lifetime_name, shm::Permissions::ReadWrite, opts)};
+
+        other.reset();
+        expectExists(true, "after a non-owner detached");
+        owner.reset();
+        expectExists(false, "after the owner detached");
+    }
+    std::cout << "Owner: ok\n";
+
+    // Persistent: never removed
+    {
+        const auto opts {withLifetime(shm::Lifetime::Persistent)};
+        {
+            Obj mem(shmTest::lifetime_name, shm::Permissions::ReadWrite, opts);
+            mem = 1234;
+        }
+        expectExists(true, "after a persistent SMO was detached");
+
+        Obj mem(shmTest::lifetime_name, shm::Permissions::ReadOnly, opts);
+        if (mem.get() != 1234)
+            throw std::runtime_error("Persistent SMO lost its data");
+
+        shm_unlink(shmTest::lifetime_name.c_str());
+    }
+    std::cout << "Persistent: ok\n";
+
+    // LastDetacher: removed when the last writer detaches, whoever created it
+    {
+        const auto opts {withLifetime(shm::Lifetime::LastDetacher)};
+        // Handles of one process share a mapping unless their options differ
+        auto separate {opts};
+        separate.populate = true;
+
+        std::unique_ptr<Obj> a {new Obj(shmTest::lifetime_name, shm::Permissions::ReadWrite, opts)};
+        std::unique_ptr<Obj> b {new Obj(shmTest::lifetime_name, shm::Permissions::ReadWrite, separate)};
+        *a = 5678;
+
+        destroyInChild(a);
+        destroyInChild(b);
+        expectExists(true, "after a forked child's copies detached");
+
+        a.reset();
+        expectExists(true, "after the creator detached");
+
+        // A restarted attacher finds the data still there
+        std::unique_ptr<Obj> c {new Obj(shmTest::lifetime_name, shm::Permissions::ReadWrite, opts)};
+        if (c->get() != 5678)
+            throw std::runtime_error("SMO lost its data between attachers");
+
+        // Readers are not counted
+        std::unique_ptr<Obj> reader {new Obj(shmTest::lifetime_name, shm::Permissions::ReadOnly, opts)};
+
+        b.reset();
+        expectExists(true, "with a writer still attached");
+        c.reset();
+        expectExists(false, "after the last writer detached");
+
+        if (reader->get() != 5678)
+            throw std::runtime_error("Reader lost its mapping");
+    }
+    std::cout << "LastDetacher: ok\n";
+}
@@ -0,0 +1,74 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int main() {
+    shm::Options opts;
+    opts.backend = shm::Backend::Memfd;
+
+    shm::Array<shmTest::memfd_type, shmTest::memfd_size> writer(shmTest::memfd_name,
+        shm::Permissions::ReadWrite, opts);
+
+    std::iota(writer.begin(), writer.end(), 0);
+
+    if (shm::exists(shmTest::memfd_name))
+        throw std::runtime_error("A memfd has a name");
+    if (writer.descriptor() == -1)
+        throw std::runtime_error("A memfd has no descriptor");
+
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == -1)
+        throw std::runtime_error("Failed to create a socket pair");
+
+    std::cout.flush();
+    const auto pid {fork()};
+
+    if (pid == 0) {
+        // Child: only knows about the memory through the socket
+        close(sockets[0]);
+        const auto fd {shm::receiveDescriptor(sockets[1])};
+        close(sockets[1]);
+
+        shm::Array<shmTest::memfd_type, shmTest::memfd_size> reader(fd,
+            shm::Permissions::ReadOnly);
+        close(fd);
+
+        for (size_t i {0}; i < shmTest::memfd_size; i++) {
+            if (reader[i] != i)
+                throw std::runtime_error("Data received incorrectly at " + std::to_string(i));
+        }
+
+        // The size is sealed
+        if (ftruncate(reader.descriptor(), 0) != -1)
+            throw std::runtime_error("Shrank a sealed memfd");
+
+        std::cout << "Child received " << shmTest::memfd_size << " elements\n";
+        return 0;
+    }
+    else if (pid < 0) {
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+
+    close(sockets[1]);
+    shm::sendDescriptor(sockets[0], writer.descriptor());
+    close(sockets[0]);
+
+    int status {0};
+    waitpid(pid, &status, 0);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw std::runtime_error("Child failed");
+
+    // Growing is refused too
+    if (ftruncate(writer.descriptor(), 1 << 20) != -1)
+        throw std::runtime_error("Grew a sealed memfd");
+
+    std::cout << "Memfd test passed\n";
+
+    return 0;
+}
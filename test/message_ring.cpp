@@ -0,0 +1,92 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using Ring = shm::MessageRing<shmTest::message_ring_size>;
+
+/** @returns The length of message number @a n. */
+size_t messageLength(uint64_t n) {
+    // Mostly small, with the occasional large one
+    const auto x {(n * 2654435761u) >> 7};
+    return sizeof(n) + (n % 64 == 0 ? x % (shmTest::message_max - sizeof(n)) : x % 56);
+}
+
+int main() {
+    shm_unlink(shmTest::message_name.c_str());
+
+    Ring ring(shmTest::message_name);
+
+    if (!ring.empty())
+        throw std::runtime_error("New ring not empty");
+
+    try {
+        ring.try_reserve(ring.max_message() + 1);
+        throw std::logic_error("Reserved more than the maximum message");
+    }
+    catch (const std::length_error&) {}
+
+    std::cout.flush();
+    const auto pid {fork()};
+
+    if (pid == 0) {
+        // Child: producer
+        for (uint64_t n {0}; n < shmTest::message_count; n++) {
+            const auto length {messageLength(n)};
+
+            unsigned char* p;
+            while ((p = ring.try_reserve(length)) == nullptr)
+                std::this_thread::yield();
+
+            std::memcpy(p, &n, sizeof(n));
+            for (size_t i {sizeof(n)}; i < length; i++)
+                p[i] = static_cast<unsigned char>(n ^ i);
+
+            if (reinterpret_cast<uintptr_t>(p) % 8 != 0)
+                throw std::runtime_error("Reserved space not aligned");
+
+            ring.commit();
+        }
+
+        return 0;
+    }
+    else if (pid < 0) {
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+
+    // Parent: consumer
+    for (uint64_t n {0}; n < shmTest::message_count; n++) {
+        size_t length;
+        const unsigned char* p;
+        while ((p = ring.peek(length)) == nullptr)
+            std::this_thread::yield();
+
+        uint64_t got;
+        std::memcpy(&got, p, sizeof(got));
+
+        if (got != n || length != messageLength(n))
+            throw std::runtime_error("Message " + std::to_string(n) + " framed incorrectly");
+
+        for (size_t i {sizeof(n)}; i < length; i++) {
+            if (p[i] != static_cast<unsigned char>(n ^ i))
+                throw std::runtime_error("Message " + std::to_string(n) + " corrupted");
+        }
+
+        ring.consume();
+    }
+
+    int status {0};
+    waitpid(pid, &status, 0);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw std::runtime_error("Producer failed");
+    if (!ring.empty())
+        throw std::runtime_error("Ring not empty at the end");
+
+    std::cout << "Passed " << shmTest::message_count << " messages\n";
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using Mirrored = shm::MirroredArray<shmTest::mirror_type, shmTest::mirror_size>;
+
+int main() {
+    shm_unlink(shmTest::mirror_name.c_str());
+
+    Mirrored arr(shmTest::mirror_name);
+
+    // Writes through the mirror land in the array
+    for (size_t i {0}; i < shmTest::mirror_size; i++)
+        arr[shmTest::mirror_size + i] = static_cast<shmTest::mirror_type>(i);
+
+    for (size_t i {0}; i < shmTest::mirror_size; i++) {
+        if (arr[i] != i)
+            throw std::runtime_error("Mirror element " + std::to_string(i) + " incorrect");
+    }
+
+    // A window across the end is contiguous
+    const auto start {shmTest::mirror_size - 10};
+    std::vector<shmTest::mirror_type> copy(20);
+    std::memcpy(copy.data(), arr.window(start), copy.size() * sizeof(shmTest::mirror_type));
+
+    for (size_t i {0}; i < copy.size(); i++) {
+        if (copy[i] != (start + i) % shmTest::mirror_size)
+            throw std::runtime_error("Window element " + std::to_string(i) + " incorrect");
+    }
+
+    std::cout.flush();
+    const auto pid {fork()};
+
+    if (pid == 0) {
+        // Child: another process sees the same data, mirrored too
+        Mirrored reader(shmTest::mirror_name, shm::Permissions::ReadOnly);
+
+        for (size_t i {0}; i < 2 * shmTest::mirror_size; i++) {
+            if (reader[i] != i % shmTest::mirror_size)
+                throw std::runtime_error("Reader element " + std::to_string(i) + " incorrect");
+        }
+
+        return 0;
+    }
+    else if (pid < 0) {
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+
+    int status {0};
+    waitpid(pid, &status, 0);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw std::runtime_error("Child failed");
+
+    // Mirroring needs whole pages
+    try {
+        shm::MirroredArray<char, 100> small(shmTest::mirror_name + "_Small");
+        throw std::logic_error("Mirrored a partial page");
+    }
+    catch (const shm::MemoryError& e) {
+        std::cout << "Partial page: " << e.what() << '\n';
+    }
+
+    std::cout << "Mirrored test passed\n";
+
+    return 0;
+}
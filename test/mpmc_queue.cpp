@@ -0,0 +1,118 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <unistd.h>
+#include <sys/wait.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using Queue = shm::MpmcQueue<shmTest::queue_type, shmTest::queue_size>;
+using Results = shm::Array<shmTest::queue_type, shmTest::queue_max_procs>;
+
+// Pushes this producer's share of the values 1..queue_count
+void produce(Queue& queue, size_t id, size_t producers) {
+    for (shmTest::queue_type v {id + 1}; v <= shmTest::queue_count; v += producers) {
+        while (!queue.try_push(v))
+            std::this_thread::yield();
+    }
+}
+
+// Pops and sums values until a zero (stop) value is received
+void consume(Queue& queue, Results& results, size_t id) {
+    shmTest::queue_type sum {0};
+
+    while (true) {
+        shmTest::queue_type v;
+        while (!queue.try_pop(v))
+            std::this_thread::yield();
+
+        if (v == 0)
+            break;
+
+        sum += v;
+    }
+
+    results[id] = sum;
+}
+
+// Forks a process running @a fn and returns its pid
+template<class Fn>
+pid_t spawn(Fn fn) {
+    // Don't let the child inherit (and re-print) buffered output
+    std::cout.flush();
+
+    const auto pid {fork()};
+
+    if (pid == 0) {
+        fn();
+        std::cout.flush();
+        _exit(0);
+    }
+    else if (pid < 0) {
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+
+    return pid;
+}
+
+void run(Queue& queue, Results& results, size_t producers, size_t consumers) {
+    std::vector<pid_t> pids;
+
+    for (auto& r : results)
+        r = 0;
+
+    const auto start {std::chrono::steady_clock::now()};
+
+    for (size_t c {0}; c < consumers; c++)
+        pids.push_back(spawn([&]{ consume(queue, results, c); }));
+
+    for (size_t p {0}; p < producers; p++)
+        pids.push_back(spawn([&]{ produce(queue, p, producers); }));
+
+    // Wait for the producers, then stop the consumers
+    for (size_t p {0}; p < producers; p++)
+        waitpid(pids[consumers + p], nullptr, 0);
+
+    for (size_t c {0}; c < consumers; c++) {
+        while (!queue.try_push(0))
+            std::this_thread::yield();
+    }
+
+    for (size_t c {0}; c < consumers; c++)
+        waitpid(pids[c], nullptr, 0);
+
+    const std::chrono::duration<double> elapsed {
+        std::chrono::steady_clock::now() - start
+    };
+
+    shmTest::queue_type sum {0};
+    for (const auto& r : results)
+        sum += r;
+
+    std::cout << producers << " producer(s), " << consumers << " consumer(s): "
+        << shmTest::queue_count / elapsed.count() / 1e6 << " M msg/s\n";
+
+    if (sum != shmTest::queue_count * (shmTest::queue_count + 1) / 2)
+        throw std::runtime_error("Queue lost or duplicated elements");
+
+    if (!queue.empty())
+        throw std::runtime_error("Queue not empty after consumption");
+}
+
+int main() {
+    // Start from an empty queue, whatever a previous run left behind
+    shm_unlink(shmTest::queue_name.c_str());
+
+    // Mapped before forking so every worker shares the same segments
+    Queue queue(shmTest::queue_name);
+    Results results(shmTest::queue_result_name);
+
+    for (size_t n {1}; n <= shmTest::queue_max_procs; n *= 2)
+        run(queue, results, n, n);
+
+    run(queue, results, 1, shmTest::queue_max_procs);
+    run(queue, results, shmTest::queue_max_procs, 1);
+}
@@ -0,0 +1,130 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <mutex>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using Shared = shm::Object<shmTest::mutex_type>;
+
+// Forks a process running @a fn, and waits for it
+template<class Fn>
+int run_child(Fn fn) {
+    std::cout.flush();
+    const auto pid {fork()};
+
+    if (pid == 0) {
+        fn();
+        std::cout.flush();
+        _exit(0);
+    }
+    else if (pid < 0) {
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+
+    int status {0};
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int main() {
+    shm_unlink(shmTest::mutex_name.c_str());
+
+    Shared shared(shmTest::mutex_name);
+    auto& s {shared.emplace()};
+
+    // Mutual exclusion between processes
+    std::cout.flush();
+    std::vector<pid_t> children;
+
+    for (size_t c {0}; c < shmTest::mutex_children; c++) {
+        const auto pid {fork()};
+
+        if (pid == 0) {
+            Shared child(shmTest::mutex_name);
+            auto& cs {child.get()};
+
+            for (uint64_t i {0}; i < shmTest::mutex_rounds; i++) {
+                std::lock_guard<shm::Mutex> guard {cs.mutex};
+                if (cs.in_section++ != 0)
+                    throw std::runtime_error("Two processes hold the mutex");
+                cs.counter++;
+                if (i % 256 == 0)
+                    std::this_thread::yield();
+                cs.in_section--;
+            }
+
+            _exit(0);
+        }
+        else if (pid < 0) {
+            std::cerr << "Failed to fork\n";
+            exit(1);
+        }
+
+        children.push_back(pid);
+    }
+
+    for (const auto pid : children) {
+        int status {0};
+        waitpid(pid, &status, 0);
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            throw std::runtime_error("Child failed");
+    }
+
+    if (s.counter != shmTest::mutex_children * shmTest::mutex_rounds)
+        throw std::runtime_error("Counter incorrect: " + std::to_string(s.counter));
+
+    // A child dies holding the mutex, in the middle of an update
+    run_child([&]() {
+        s.mutex.lock();
+        s.in_section = 1;
+    });
+
+    bool recovered {false};
+    s.mutex.lock([&]() {
+        recovered = true;
+        s.in_section = 0;
+        return true;
+    });
+    s.mutex.unlock();
+
+    if (!recovered || s.in_section != 0)
+        throw std::runtime_error("Owner death not recovered");
+
+    // Once recovered, the mutex is usable as normal
+    s.mutex.lock([]() -> bool { throw std::logic_error("Recovered twice"); });
+    s.mutex.unlock();
+
+    if (!s.mutex.try_lock())
+        throw std::runtime_error("Could not try_lock a free mutex");
+    if (run_child([&]() { if (s.mutex.try_lock()) _exit(1); }) != 0)
+        throw std::runtime_error("try_lock took a held mutex");
+    s.mutex.unlock();
+
+    // A failed recovery leaves the mutex unusable
+    run_child([&]() { s.abandoned.lock(); });
+
+    try {
+        s.abandoned.lock([]() { return false; });
+        throw std::logic_error("Locked after a failed recovery");
+    }
+    catch (const shm::LockError& e) {
+        std::cout << "Failed recovery: " << e.what() << '\n';
+    }
+
+    try {
+        std::lock_guard<shm::Mutex> guard {s.abandoned};
+        throw std::logic_error("Locked an unrecoverable mutex");
+    }
+    catch (const shm::LockError& e) {
+        std::cout << "Unrecoverable: " << e.what() << '\n';
+    }
+
+    std::cout << "Mutex test passed\n";
+
+    return 0;
+}
@@ -15,12 +15,15 @@ bool getObjZ(const shmTest::obj_type& o) {
 }
 
 int main() {
+    // Created before forking, as the read-only receiver only attaches
+    shm::Object<shmTest::obj_type> writer(shmTest::obj_name);
+
     const auto pid {fork()};
 
     if (pid > 0) {
         // Parent (sender)
 
-        shm::Object<shmTest::obj_type> mem(shmTest::obj_name);
+        auto& mem = writer;
 
         std::cout << "Sender launched\n";
 
@@ -28,12 +31,17 @@ int main() {
         mem->x = shmTest::obj_value.x;
         mem.get().y = shmTest::obj_value.y;
         setObjZ(mem);
+        mem.notify();
 
         std::cout << "Data sent\n";
 
-        waitpid(pid, nullptr, 0);
+        int status {0};
+        waitpid(pid, &status, 0);
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            throw std::runtime_error("Receiver failed");
 
-        // Check data was not changed by read-only receiver
+        // Check data was not changed by the read-only receiver
         if (mem->x != shmTest::obj_value.x)
             throw std::runtime_error("Object was changed by read-only mapping");
 
@@ -52,6 +60,8 @@ int main() {
             ) {
                 break;
             }
+
+            mem.wait_for_change();
         };
 
         std::cout << "Data received:\n";
@@ -59,11 +69,6 @@ int main() {
         std::cout << "y: " << mem.get().y << '\t';
         std::cout << "z: " << std::boolalpha << getObjZ(mem) << '\n';
 
-        // Test for read-only-ness
-        mem->x = ~mem->x;
-        // Ensure enough time has passed for data carry-through
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
-
     }
     else {
         // Error
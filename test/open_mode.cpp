@@ -0,0 +1,147 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+shm::Options withMode(shm::OpenMode mode) {
+    shm::Options opts;
+    opts.open_mode = mode;
+    return opts;
+}
+
+int main() {
+    shm_unlink(shmTest::open_name.c_str());
+
+    // Attaching to a missing SMO fails, and does not create it
+    try {
+        shm::Array<char, shmTest::open_size> mem(shmTest::open_name,
+            shm::Permissions::ReadOnly, withMode(shm::OpenMode::Open));
+        throw std::logic_error("Attached to a missing SMO");
+    }
+    catch (const shm::FileError& e) {
+        std::cout << "Open missing: " << e.what() << '\n';
+    }
+
+    if (shm::exists(shmTest::open_name))
+        throw std::runtime_error("Attaching created the SMO");
+
+    // Readers only ever attach, even in the default CreateOrOpen mode
+    try {
+        shm::Array<char, shmTest::open_size> mem(shmTest::open_name,
+            shm::Permissions::ReadOnly);
+        throw std::logic_error("A reader attached to a missing SMO");
+    }
+    catch (const shm::FileError& e) {
+        std::cout << "Read missing: " << e.what() << '\n';
+    }
+
+    if (shm::exists(shmTest::open_name))
+        throw std::runtime_error("A reader created the SMO");
+
+    shm::Array<char, shmTest::open_size> writer(shmTest::open_name,
+        shm::Permissions::ReadWrite, withMode(shm::OpenMode::Create));
+    writer[0] = 42;
+
+    // Creating an existing SMO fails
+    try {
+        shm::Array<char, shmTest::open_size> mem(shmTest::open_name,
+            shm::Permissions::ReadWrite, withMode(shm::OpenMode::Create));
+        throw std::logic_error("Created an existing SMO");
+    }
+    catch (const shm::FileError& e) {
+        std::cout << "Create existing: " << e.what() << '\n';
+    }
+
+    // A smaller reader attaches without resizing the SMO
+    shm::Array<char, shmTest::open_size / 2> reader(shmTest::open_name,
+        shm::Permissions::ReadOnly, withMode(shm::OpenMode::Open));
+
+    if (reader[0] != 42)
+        throw std::runtime_error("Reader did not see the writer's data");
+
+#ifdef __linux__
+    struct stat st;
+    if (stat(("/dev/shm" + shmTest::open_name).c_str(), &st) == -1)
+        throw std::runtime_error("SMO not found in /dev/shm");
+    if (static_cast<size_t>(st.st_size) != sizeof(shm::_SegmentHeader) + shmTest::open_size)
+        throw std::runtime_error("Reader resized the SMO");
+#endif
+
+    // A reader's mapping is truly read-only: writing through it faults
+    std::cout.flush();
+    const auto pid {fork()};
+
+    if (pid == 0) {
+        reader[1] = 1;
+        _exit(0);
+    }
+    else if (pid < 0) {
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+
+    int status {0};
+    waitpid(pid, &status, 0);
+
+    if (!WIFSIGNALED(status))
+        throw std::runtime_error("Wrote through a read-only mapping");
+    if (writer[1] != 0)
+        throw std::runtime_error("Write through a read-only mapping was visible");
+
+    std::cout << "Read-only write faulted with signal " << WTERMSIG(status) << '\n';
+
+    // Writers never shrink an existing SMO, and only CreateOrOpen grows it.
+    // It is created outside the library so that no mapping of it is shared.
+    const auto resize_name {shmTest::open_name + "_Resize"};
+    const auto full_size {sizeof(shm::_SegmentHeader) + shmTest::open_size};
+    shm_unlink(resize_name.c_str());
+
+    const auto fd {shm_open(resize_name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRWXU)};
+    if (fd == -1 || ftruncate(fd, full_size) == -1)
+        throw std::runtime_error("Could not create " + resize_name);
+
+    const auto smo_size {[fd]() {
+        struct stat st;
+        if (fstat(fd, &st) == -1)
+            throw std::runtime_error("Could not get the SMO's size");
+        return static_cast<size_t>(st.st_size);
+    }};
+
+    for (const auto mode : {shm::OpenMode::Open, shm::OpenMode::CreateOrOpen}) {
+        shm::Array<char, shmTest::open_size / 2> small(resize_name,
+            shm::Permissions::ReadWrite, withMode(mode));
+        small[0] = 1;
+
+        if (smo_size() != full_size)
+            throw std::runtime_error("A smaller writer resized the SMO");
+    }
+
+    try {
+        shm::Array<char, 2 * shmTest::open_size> large(resize_name,
+            shm::Permissions::ReadWrite, withMode(shm::OpenMode::Open));
+        throw std::logic_error("Opened an SMO smaller than the data");
+    }
+    catch (const shm::FileError& e) {
+        std::cout << "Open too small: " << e.what() << '\n';
+    }
+
+    if (smo_size() != full_size)
+        throw std::runtime_error("A larger writer with OpenMode::Open resized the SMO");
+
+    {
+        shm::Array<char, 2 * shmTest::open_size> large(resize_name,
+            shm::Permissions::ReadWrite, withMode(shm::OpenMode::CreateOrOpen));
+
+        if (large[0] != 1)
+            throw std::runtime_error("Growing the SMO lost its data");
+    }
+
+    if (smo_size() != sizeof(shm::_SegmentHeader) + 2 * shmTest::open_size)
+        throw std::runtime_error("A larger writer with OpenMode::CreateOrOpen did not grow the SMO");
+
+    close(fd);
+    shm_unlink(resize_name.c_str());
+}
@@ -0,0 +1,67 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using PersistentArray = shm::Array<shmTest::persist_type, shmTest::persist_size, shm::FileBackend>;
+
+shm::Options persistent() {
+    shm::Options opts;
+    opts.lifetime = shm::Lifetime::Persistent;
+    return opts;
+}
+
+int main() {
+    unlink(shmTest::persist_file.c_str());
+
+    // First run: build the state, then exit
+    std::cout.flush();
+    const auto pid {fork()};
+
+    if (pid == 0) {
+        auto opts {persistent()};
+        opts.flush_interval = std::chrono::milliseconds(1);
+
+        PersistentArray arr(shmTest::persist_file, shm::Permissions::ReadWrite, opts);
+        std::iota(arr.begin(), arr.end(), 0);
+
+        // Unaligned sub-range first, then everything
+        arr.flush(arr.begin() + 1000, arr.begin() + 2000, shm::Flush::Async);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        arr.flush();
+
+        return 0;
+    }
+    else if (pid < 0) {
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+
+    int status {0};
+    waitpid(pid, &status, 0);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw std::runtime_error("First run failed");
+
+    // Restart: the state maps straight back in
+    auto opts {persistent()};
+    opts.open_mode = shm::OpenMode::Open;
+
+    {
+        PersistentArray arr(shmTest::persist_file, shm::Permissions::ReadOnly, opts);
+
+        for (size_t i {0}; i < shmTest::persist_size; i++) {
+            if (arr[i] != i)
+                throw std::runtime_error("Element " + std::to_string(i) + " not persisted");
+        }
+    }
+
+    if (unlink(shmTest::persist_file.c_str()) == -1)
+        throw std::runtime_error("Persistent file was removed");
+
+    std::cout << "Persistent test passed\n";
+
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <set>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using OrderPool = shm::Pool<shmTest::pool_type, shmTest::pool_size>;
+
+int main() {
+    shm_unlink(shmTest::pool_name.c_str());
+
+    OrderPool pool(shmTest::pool_name);
+
+    std::cout.flush();
+    std::vector<pid_t> children;
+
+    for (size_t c {0}; c < shmTest::pool_children; c++) {
+        const auto pid {fork()};
+
+        if (pid == 0) {
+            // Child: allocate, stamp and free slots; a slot handed out twice
+            // gets overwritten by its other owner. Half use a local cache.
+            OrderPool p(shmTest::pool_name, c % 2 == 0 ? 16 : 0);
+            const auto owner {static_cast<uint64_t>(c + 1)};
+            uint32_t held[8];
+
+            for (uint64_t round {0}; round < shmTest::pool_rounds; round++) {
+                for (auto& i : held) {
+                    if (!p.try_allocate(i))
+                        throw std::runtime_error("Pool exhausted");
+                    p[i].owner = owner;
+                    p[i].round = round;
+                }
+
+                if (round % 64 == 0)
+                    std::this_thread::yield();
+
+                for (const auto i : held) {
+                    if (p[i].owner != owner || p[i].round != round)
+                        throw std::runtime_error("Slot " + std::to_string(i) + " shared");
+                    p.deallocate(i);
+                }
+            }
+
+            return 0;
+        }
+        else if (pid < 0) {
+            std::cerr << "Failed to fork\n";
+            exit(1);
+        }
+
+        children.push_back(pid);
+    }
+
+    for (const auto pid : children) {
+        int status {0};
+        waitpid(pid, &status, 0);
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            throw std::runtime_error("Child failed");
+    }
+
+    // Every slot, and no more, is free again: caches were drained
+    std::set<uint32_t> seen;
+    uint32_t index;
+
+    while (pool.try_allocate(index)) {
+        if (index >= shmTest::pool_size || !seen.insert(index).second)
+            throw std::runtime_error("Bad or repeated slot " + std::to_string(index));
+    }
+
+    if (seen.size() != shmTest::pool_size)
+        throw std::runtime_error("Pool lost " + std::to_string(shmTest::pool_size - seen.size()) + " slots");
+
+    for (const auto i : seen)
+        pool.deallocate(i);
+
+    // A cache holds slots back, and returns them when drained
+    OrderPool cached(shmTest::pool_name, 32);
+    if (!cached.try_allocate(index) || cached.cached() != 15)
+        throw std::runtime_error("Cache not refilled in a batch");
+    cached.deallocate(index);
+    if (pool.index_of(&pool[index]) != index)
+        throw std::runtime_error("index_of incorrect");
+
+    cached.drain();
+    seen.clear();
+    while (pool.try_allocate(index))
+        seen.insert(index);
+
+    if (seen.size() != shmTest::pool_size)
+        throw std::runtime_error("Drained cache lost slots");
+
+    std::cout << "Pool test passed\n";
+
+    return 0;
+}
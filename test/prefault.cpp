@@ -0,0 +1,71 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+// Checks that every page of [begin, end) is resident
+void checkResident(const void* begin, const void* end) {
+    const auto page {static_cast<uintptr_t>(sysconf(_SC_PAGESIZE))};
+    const auto first {reinterpret_cast<uintptr_t>(begin) / page * page};
+    const auto last {reinterpret_cast<uintptr_t>(end)};
+    const auto pages {(last - first + page - 1) / page};
+
+    std::vector<unsigned char> vec(pages);
+    if (mincore(reinterpret_cast<void*>(first), last - first, vec.data()) == -1)
+        throw std::runtime_error("mincore failed");
+
+    for (const auto v : vec) {
+        if ((v & 1) == 0)
+            throw std::runtime_error("Page not resident after prefaulting");
+    }
+}
+
+int main() {
+    shm_unlink(shmTest::prefault_name.c_str());
+
+    // Explicit parallel pre-touch and locking
+    {
+        shm::Options opts;
+        opts.pretouch_threads = 4;
+        opts.lock = true;
+
+        shm::Array<char, shmTest::prefault_size> mem(shmTest::prefault_name,
+            shm::Permissions::ReadWrite, opts);
+
+        std::cout << "Pre-touched and locked in " << mem.prefault_time().count() << " ns\n";
+
+        if (mem.prefault_time().count() <= 0)
+            throw std::runtime_error("Prefault time not reported");
+
+        checkResident(mem.begin(), mem.end());
+    }
+
+    // MAP_POPULATE
+    {
+        shm::Options opts;
+        opts.populate = true;
+
+        shm::Array<char, shmTest::prefault_size> mem(shmTest::prefault_name,
+            shm::Permissions::ReadWrite, opts);
+
+        std::cout << "Populated in " << mem.prefault_time().count() << " ns\n";
+
+        if (mem.prefault_time().count() <= 0)
+            throw std::runtime_error("Prefault time not reported");
+
+#ifdef MAP_POPULATE
+        checkResident(mem.begin(), mem.end());
+#endif
+    }
+
+    // No prefaulting
+    {
+        shm::Array<char, shmTest::prefault_size> mem(shmTest::prefault_name);
+
+        if (mem.prefault_time().count() != 0)
+            throw std::runtime_error("Prefault time reported without prefaulting");
+    }
+}
@@ -0,0 +1,121 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using Counter = std::atomic<uint64_t>;
+using Values = std::array<double, 16>;
+using Vector = std::vector<uint64_t, shm::Allocator<uint64_t>>;
+
+int main() {
+    shm_unlink(shmTest::segment_name.c_str());
+
+    shm::Segment segment(shmTest::segment_name, shmTest::segment_size, shmTest::segment_objects);
+
+    auto& values {segment.find_or_construct<Values>("values")};
+    for (size_t i {0}; i < values.size(); i++)
+        values[i] = 0.5 * i;
+
+    auto& vec {segment.find_or_construct<Vector>("vector", segment.allocator<uint64_t>())};
+    vec.assign({1, 2, 3});
+
+    // Existing objects are returned as they are
+    if (&segment.find_or_construct<Values>("values") != &values)
+        throw std::runtime_error("Object constructed twice");
+    if (segment.find<Values>("missing") != nullptr)
+        throw std::runtime_error("Found a missing object");
+
+    try {
+        segment.find<Counter>("values");
+        throw std::logic_error("Found an object with the wrong type");
+    }
+    catch (const shm::LayoutError& e) {
+        std::cout << "Wrong type: " << e.what() << '\n';
+    }
+
+    std::cout.flush();
+    std::vector<pid_t> children;
+
+    for (size_t c {0}; c < shmTest::segment_children; c++) {
+        const auto pid {fork()};
+
+        if (pid == 0) {
+            // Child: every child constructs the counter, only the first wins
+            shm::Segment s(shmTest::segment_name);
+            auto& hits {s.find_or_construct<Counter>("hits", 0)};
+            hits.fetch_add(1);
+
+            s.find_or_construct<uint64_t>("child" + std::to_string(c), c);
+
+            // A read-only mapping, at another address, finds the same data
+            const shm::Segment reader(shmTest::segment_name, shm::Permissions::ReadOnly);
+            const auto v {reader.find<Values>("values")};
+            const auto w {reader.find<Vector>("vector")};
+
+            if (v == nullptr || (*v)[15] != 7.5)
+                throw std::runtime_error("Values incorrect in the reader");
+            if (w == nullptr || w->size() != 3 || (*w)[2] != 3)
+                throw std::runtime_error("Vector incorrect in the reader");
+
+            // Read-only handles cannot construct objects, even existing ones
+            try {
+                shm::Segment ro(shmTest::segment_name, shm::Permissions::ReadOnly);
+                ro.find_or_construct<Counter>("hits", 0);
+                throw std::logic_error("Constructed in a read-only segment");
+            }
+            catch (const shm::FileError&) {}
+
+            // Skip destructors, which would remove the parent's SMO
+            _exit(0);
+        }
+        else if (pid < 0) {
+            std::cerr << "Failed to fork\n";
+            exit(1);
+        }
+
+        children.push_back(pid);
+    }
+
+    for (const auto pid : children) {
+        int status {0};
+        waitpid(pid, &status, 0);
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            throw std::runtime_error("Child failed");
+    }
+
+    const auto hits {segment.find<Counter>("hits")};
+    if (hits == nullptr || hits->load() != shmTest::segment_children)
+        throw std::runtime_error("Counter not shared between children");
+
+    for (size_t c {0}; c < shmTest::segment_children; c++) {
+        const auto child {segment.find<uint64_t>("child" + std::to_string(c))};
+        if (child == nullptr || *child != c)
+            throw std::runtime_error("Child object " + std::to_string(c) + " incorrect");
+    }
+
+    // Fill the directory
+    try {
+        for (size_t i {0}; ; i++)
+            segment.find_or_construct<uint64_t>("fill" + std::to_string(i), i);
+    }
+    catch (const std::length_error& e) {
+        std::cout << "Directory full at " << segment.count() << " objects: " << e.what() << '\n';
+    }
+
+    if (segment.count() < shmTest::segment_objects)
+        throw std::runtime_error("Directory full too early");
+
+    for (size_t i {0}; i + 4 + shmTest::segment_children < segment.count(); i++) {
+        const auto fill {segment.find<uint64_t>("fill" + std::to_string(i))};
+        if (fill == nullptr || *fill != i)
+            throw std::runtime_error("Object fill" + std::to_string(i) + " incorrect");
+    }
+
+    std::cout << "Segment test passed\n";
+
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <unistd.h>
+#include <sys/wait.h>
+#include <thread>
+
+int main() {
+    // Start from a zero value, whatever a previous run left behind
+    shm_unlink(shmTest::seq_name.c_str());
+
+    // Created before forking, as the read-only receiver only attaches
+    shm::SeqObject<shmTest::seq_type> writer(shmTest::seq_name);
+
+    const auto pid {fork()};
+
+    if (pid > 0) {
+        // Parent (writer)
+
+        auto& mem = writer;
+
+        std::cout << "Writer launched\n";
+
+        for (uint64_t i {1}; i <= shmTest::seq_count; i++)
+            mem.store({i, i, i, i});
+
+        std::cout << "Data sent\n";
+
+        int status {0};
+        waitpid(pid, &status, 0);
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            throw std::runtime_error("Reader observed a torn or stale value");
+
+    }
+    else if (pid == 0) {
+        // Child (reader)
+
+        std::cout << "Receiver launched\n";
+
+        shm::SeqObject<shmTest::seq_type> mem(shmTest::seq_name, shm::Permissions::ReadOnly);
+
+        uint64_t last {0};
+        size_t reads {0};
+
+        while (last != shmTest::seq_count) {
+            const auto v {mem.load()};
+            reads++;
+
+            if (v.a != v.b || v.a != v.c || v.a != v.d)
+                throw std::runtime_error("Torn read");
+            if (v.a < last)
+                throw std::runtime_error("Value went backwards");
+
+            last = v.a;
+
+            if (reads % 64 == 0)
+                std::this_thread::yield();
+        }
+
+        std::cout << "Data received after " << reads << " reads\n";
+
+    }
+    else {
+        // Error
+
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+}
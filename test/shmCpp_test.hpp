@@ -4,6 +4,8 @@
 #include "shmCpp.hpp"
 
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <numeric>
 
 namespace shmTest {
@@ -35,6 +37,242 @@ static constexpr std::array<arr_type, arr_size> arr_seq {4, 8, 6286, 2, 264};
 
 static const auto arr_sum {std::accumulate(arr_seq.begin(), arr_seq.end(), 0)};
 
+
+// DynArray testing
+const std::string dyn_name {shm::formatName("ShmCpp_Test_DynArray")};
+
+static constexpr size_t dyn_size {1000};
+
+
+// OpenMode testing
+const std::string open_name {shm::formatName("ShmCpp_Test_OpenMode")};
+
+static constexpr size_t open_size {100};
+
+
+// Handle testing
+const std::string handle_name {shm::formatName("ShmCpp_Test_Handle")};
+
+static constexpr size_t handle_count {16};
+
+static constexpr size_t handle_rounds {2000};
+
+
+// Lifetime testing
+const std::string lifetime_name {shm::formatName("ShmCpp_Test_Lifetime")};
+
+
+// Prefault testing
+const std::string prefault_name {shm::formatName("ShmCpp_Test_Prefault")};
+
+static constexpr size_t prefault_size {1024 * 1024};
+
+
+// SeqObject testing
+struct seq_type {
+    uint64_t a, b, c, d;
+};
+
+const std::string seq_name {shm::formatName("ShmCpp_Test_SeqObject")};
+
+static constexpr uint64_t seq_count {200000};
+
+
+// LatestValue testing
+struct latest_type {
+    uint64_t values[512];
+};
+
+const std::string latest_name {shm::formatName("ShmCpp_Test_LatestValue")};
+
+static constexpr uint64_t latest_count {20000};
+
+
+// SpscRing testing
+using ring_type = uint64_t;
+
+const std::string ring_name {shm::formatName("ShmCpp_Test_SpscRing")};
+
+static constexpr size_t ring_size {1024};
+
+static constexpr ring_type ring_count {1000000};
+
+
+// MpmcQueue testing
+using queue_type = uint64_t;
+
+const std::string queue_name {shm::formatName("ShmCpp_Test_MpmcQueue")};
+
+const std::string queue_result_name {shm::formatName("ShmCpp_Test_MpmcQueue_Result")};
+
+static constexpr size_t queue_size {1024};
+
+static constexpr queue_type queue_count {200000};
+
+static constexpr size_t queue_max_procs {4};
+
+
+// memfd testing
+using memfd_type = uint32_t;
+
+const std::string memfd_name {"ShmCpp_Test_Memfd"};
+
+static constexpr size_t memfd_size {4096};
+
+
+// Anonymous mapping testing
+using anon_type = uint64_t;
+
+const std::string anon_name {shm::formatName("ShmCpp_Test_Anonymous")};
+
+static constexpr size_t anon_size {1000};
+
+static constexpr size_t anon_ring_size {64};
+
+static constexpr anon_type anon_count {100000};
+
+
+// Backend testing
+using backend_type = uint32_t;
+
+const std::string backend_name {shm::formatName("ShmCpp_Test_Backend")};
+
+const std::string backend_file {"/tmp/ShmCpp_Test_Backend"};
+
+static constexpr size_t backend_size {10000};
+
+
+// Persistent file testing
+using persist_type = uint64_t;
+
+const std::string persist_file {"/tmp/ShmCpp_Test_Persistent"};
+
+static constexpr size_t persist_size {100000};
+
+
+// Layout checking testing
+const std::string layout_name {shm::formatName("ShmCpp_Test_Layout")};
+
+static constexpr uint32_t layout_version {3};
+
+
+// In-place construction testing
+/** A lookup table that is expensive to build, counting its constructions. */
+struct emplace_type {
+    static constexpr size_t size {4096};
+
+    emplace_type(uint64_t seed, std::atomic<uint32_t>& constructions) {
+        constructions.fetch_add(1);
+        for (size_t i {0}; i < size; i++)
+            values[i] = seed * i;
+    }
+
+    uint64_t values[size];
+};
+
+const std::string emplace_name {shm::formatName("ShmCpp_Test_Emplace")};
+
+const std::string emplace_count_name {shm::formatName("ShmCpp_Test_Emplace_Count")};
+
+static constexpr uint64_t emplace_seed {7};
+
+static constexpr size_t emplace_procs {4};
+
+
+// ChunkPool testing
+const std::string chunk_name {shm::formatName("ShmCpp_Test_ChunkPool")};
+
+static constexpr size_t chunk_size {64 * 1024};
+
+static constexpr size_t chunk_count {8};
+
+static constexpr uint64_t chunk_messages {2000};
+
+
+// MessageRing testing
+const std::string message_name {shm::formatName("ShmCpp_Test_MessageRing")};
+
+static constexpr size_t message_ring_size {64 * 1024};
+
+static constexpr size_t message_max {4096};
+
+static constexpr uint64_t message_count {200000};
+
+
+// MirroredArray testing
+using mirror_type = uint32_t;
+
+const std::string mirror_name {shm::formatName("ShmCpp_Test_Mirrored")};
+
+static constexpr size_t mirror_size {4096};
+
+
+// Heap testing
+const std::string heap_name {shm::formatName("ShmCpp_Test_Heap")};
+
+static constexpr size_t heap_size {1024 * 1024};
+
+static constexpr size_t heap_elements {1000};
+
+static constexpr size_t heap_rounds {20000};
+
+
+// Pool testing
+struct pool_type {
+    uint64_t owner;
+    uint64_t round;
+    char payload[240];
+};
+
+const std::string pool_name {shm::formatName("ShmCpp_Test_Pool")};
+
+static constexpr size_t pool_size {256};
+
+static constexpr size_t pool_children {4};
+
+static constexpr size_t pool_rounds {20000};
+
+
+// Segment testing
+const std::string segment_name {shm::formatName("ShmCpp_Test_Segment")};
+
+static constexpr size_t segment_size {1024 * 1024};
+
+static constexpr size_t segment_objects {64};
+
+static constexpr size_t segment_children {4};
+
+
+// HashMap testing
+struct map_value {
+    uint64_t key;
+    uint64_t version;
+    double price;
+};
+
+const std::string map_name {shm::formatName("ShmCpp_Test_HashMap")};
+
+static constexpr size_t map_size {1024};
+
+static constexpr size_t map_children {4};
+
+static constexpr uint64_t map_keys {400};
+
+
+// Mutex testing
+struct mutex_type {
+    shm::Mutex mutex;
+    shm::Mutex abandoned;
+    uint64_t counter;
+    uint64_t in_section;
+};
+
+const std::string mutex_name {shm::formatName("ShmCpp_Test_Mutex")};
+
+static constexpr size_t mutex_children {4};
+
+static constexpr uint64_t mutex_rounds {20000};
+
 } // namespace shm
 
 #endif
\ No newline at end of file
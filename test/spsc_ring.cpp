@@ -0,0 +1,73 @@
+#include "shmCpp.hpp"
+
+#include "shmCpp_test.hpp"
+
+#include <unistd.h>
+#include <sys/wait.h>
+#include <chrono>
+#include <thread>
+
+int main() {
+    // Start from an empty ring, whatever a previous run left behind
+    shm_unlink(shmTest::ring_name.c_str());
+
+    const auto pid {fork()};
+
+    if (pid > 0) {
+        // Parent (producer)
+
+        shm::SpscRing<shmTest::ring_type, shmTest::ring_size> ring(shmTest::ring_name);
+
+        std::cout << "Producer launched\n";
+
+        const auto start {std::chrono::steady_clock::now()};
+
+        for (shmTest::ring_type i {0}; i < shmTest::ring_count; i++) {
+            while (!ring.try_push(i))
+                std::this_thread::yield();
+        }
+
+        std::cout << "Data sent\n";
+
+        int status {0};
+        waitpid(pid, &status, 0);
+
+        const std::chrono::duration<double> elapsed {
+            std::chrono::steady_clock::now() - start
+        };
+        std::cout << "Throughput: "
+            << shmTest::ring_count / elapsed.count() / 1e6 << " M msg/s\n";
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            throw std::runtime_error("Consumer received corrupted or out-of-order data");
+
+        if (!ring.empty())
+            throw std::runtime_error("Ring not empty after consumption");
+
+    }
+    else if (pid == 0) {
+        // Child (consumer)
+
+        std::cout << "Consumer launched\n";
+
+        shm::SpscRing<shmTest::ring_type, shmTest::ring_size> ring(shmTest::ring_name);
+
+        for (shmTest::ring_type i {0}; i < shmTest::ring_count; i++) {
+            shmTest::ring_type v;
+            while (!ring.try_pop(v))
+                std::this_thread::yield();
+
+            if (v != i)
+                throw std::runtime_error("Received out-of-order data");
+        }
+
+        std::cout << "Data received: " << shmTest::ring_count << " messages\n";
+
+    }
+    else {
+        // Error
+
+        std::cerr << "Failed to fork\n";
+        exit(1);
+    }
+}